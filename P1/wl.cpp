@@ -16,13 +16,14 @@
 int main(int argc, char** argv) {
   char command[514];
   char* currCommand = command, *token = command;
-  FILE* fin = stdin, *currLoadFile = NULL;
+  FILE* fin = stdin;
   char* rc = NULL;
   command_e cmd = ERROR_e;
   createDelim();
   while (1) {
     cmd = ERROR_e;
-    wl_printf(">");
+    wl_puts(">");
+    wl_flush();
     rc = fgets(command, sizeof(command), fin);
     if (rc == NULL) continue;
 
@@ -47,80 +48,58 @@ int main(int argc, char** argv) {
     } else if (i == 3) {
       if (0 == strcasecmp(argvs[0], "locate")) cmd = LOCATE_e;
     } else {
-        wl_printf("ERROR: Invalid command\n");
+        wl_puts("ERROR: Invalid command\n");
         continue;
     }
 
     switch (cmd) {
       case LOAD_e: {
-        currLoadFile = fopen(argvs[1], "r");
-        if (NULL == currLoadFile) {
-          wl_printf("ERROR: Invalid command\n");
+        if (false == locator.loadDocument(argvs[1])) {
+          wl_puts("ERROR: Invalid command\n");
           continue;
         }
-        if (NULL != root) {
-          delete root;
-          root = NULL;
-        }
-        char line[100];
-        int idx = 1;
-        while (NULL != fgets(line, sizeof(line), currLoadFile)) {
-          currCommand = line;
-          while (NULL != (token = strtok_r(currCommand, delim.c_str(), \
-            &context))) {
-            currCommand = NULL;
-            std::string temp(token);
-            root = insert(root, temp.c_str(), idx);
-            idx++;
-          }
-        }
-        fclose(currLoadFile);
-        // inorder(root);
       }
         break;
       case LOCATE_e: {
         char* err = NULL;
         int occurence = strtol(argvs[2], &err, 10);
         if (*err != '\0') {
-          wl_printf("ERROR: Invalid command\n");
+          wl_puts("ERROR: Invalid command\n");
           continue;
         }
         if (occurence < 0) {
-          wl_printf("ERROR: Invalid command\n");
+          wl_puts("ERROR: Invalid command\n");
           continue;
         }
         if (false == checkCorrectChars(argvs[1])) {
-          wl_printf("ERROR: Invalid command\n");
+          wl_puts("ERROR: Invalid command\n");
           continue;
         }
-        std::string temp(argvs[1]);
-        node* rc = lookup(root, temp.c_str());
+        toLowerStr(argvs[1]);
+        node* rc = locator.lookup(argvs[1]);
         if (rc == NULL) {
-          wl_printf("No matching entry\n");
-        } else if (rc->index->size() < (unsigned int)occurence) {
-          wl_printf("No matching entry\n");
+          wl_puts("No matching entry\n");
+        } else if (occurence < 1 || rc->count() < (unsigned int)occurence) {
+          wl_puts("No matching entry\n");
         } else {
-          wl_printf("%d\n", (*(rc->index))[occurence - 1]);
+          wl_putu(rc->indexAt(occurence - 1));
+          wl_puts("\n");
         }
       }
         break;
       case NEW_e:
-        if (NULL != root) {
-          delete root;
-          root = NULL;
-        }
+        locator.freeTable();
         break;
       case END_e:
-        if (NULL != root) {
-          delete root;
-          root = NULL;
-        }
+        locator.freeTable();
+        wl_flush();
         return 0;
         break;
       default:
-        wl_printf("ERROR: Invalid command\n");
+        wl_puts("ERROR: Invalid command\n");
         continue;
     }
   }
+  wl_flush();
   return 0;
 }
@@ -11,7 +11,12 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
-#include <string>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <new>
 
 /// @brief Type to specify the type of input command.
 typedef enum _command {
@@ -22,193 +27,678 @@ typedef enum _command {
   ERROR_e     ///< Default error type
 } command_e;
 
-std::string delim;
-char output[1000] = {0};
+static uint8_t isWordChar[256];  ///< 1 for bytes of a word.
+static char outbuf[1 << 20];  ///< Output buffer flushed in one write.
+static size_t outlen = 0;     ///< Number of buffered bytes in outbuf.
 
-/// @brief Helper macro to print to stdout using write system call.
-#define wl_printf(format, ...) \
-  sprintf(output, format, ##__VA_ARGS__); \
-  if (write(STDOUT_FILENO, output, strlen(output)) == -1) \
+/// @brief Lookup table of the two decimal digits for every value 0-99.
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/**
+ * @brief Function to flush the buffered output with a single write call.
+ * @details Called before reading the next command (so the prompt is visible)
+ * and whenever the buffer is close to full, instead of paying one syscall
+ * per printed word or index.
+ * @return Nothing
+ */
+void wl_flush() {
+  if (outlen == 0) return;
+  if (write(STDOUT_FILENO, outbuf, outlen) == -1)
     perror("Error in writing to STDOUT\n");
+  outlen = 0;
+}
 
 /**
- * @brief Function to create a deliminator string to be used for tokenizing
-          input file via strtok_r.
+ * @brief Function to format an unsigned integer as decimal ASCII.
+ * @param dst Destination to write the digits to; not NUL terminated.
+ * @param n   Value which is to be formatted.
+ * @details Emits two digits per iteration from the digitPairs table instead
+ * of parsing a printf format string and dividing once per digit.
+ * @return The number of bytes written.
+ */
+size_t fmtU32(char* dst, uint32_t n) {
+  char tmp[10];
+  char* p = tmp + sizeof(tmp);
+  while (n >= 100) {
+    p -= 2;
+    memcpy(p, digitPairs + 2 * (n % 100), 2);
+    n /= 100;
+  }
+  if (n >= 10) {
+    p -= 2;
+    memcpy(p, digitPairs + 2 * n, 2);
+  } else {
+    *--p = (char)('0' + n);
+  }
+  size_t len = tmp + sizeof(tmp) - p;
+  memcpy(dst, p, len);
+  return len;
+}
+
+/**
+ * @brief Function to append a string to the output buffer.
+ * @param s Input string which is to be appended.
+ * @return Nothing
+ */
+void wl_puts(const char* s) {
+  size_t n = strlen(s);
+  if (outlen + n > sizeof(outbuf)) wl_flush();
+  memcpy(outbuf + outlen, s, n);
+  outlen += n;
+}
+
+/**
+ * @brief Function to append an unsigned integer to the output buffer.
+ * @param n Input value which is to be appended in decimal.
+ * @return Nothing
+ */
+void wl_putu(uint32_t n) {
+  if (outlen + 16 > sizeof(outbuf)) wl_flush();
+  outlen += fmtU32(outbuf + outlen, n);
+}
+
+/**
+ * @brief Function to create the isWordChar classification table.
+ * @details Every byte outside [0-9A-Za-z'] is a delimiter. The table gives
+ * the tokenizer and checkCorrectChars an O(1) branchless membership test;
+ * the old std::string of delimiter characters fed to strtok_r is gone along
+ * with strtok_r itself.
  * @return Nothing
  */
 void createDelim() {
-  for (int i = 1; i < 256; i++) {
-    if (i >= 48 && i <= 57) continue;   // [0-9] cannot end word
-    if (i >= 65 && i <= 90) continue;   // [A-Z] cannot end word
-    if (i >= 97 && i <= 122) continue;  // [a-z] cannot end word
-    if (i == 39) continue;              // '(Apostrophe) cannot end word
-    delim += (char)i;
+  for (unsigned c = 0; c < 256; c++) {
+    // Branchless membership in [0-9] | [A-Za-z] | {'}: each range collapses
+    // to one unsigned subtraction and compare, OR'd bitwise.
+    isWordChar[c] = (uint8_t)(((c - '0') < 10u) |
+                              (((c | 0x20u) - 'a') < 26u) |
+                              (c == '\''));
   }
 }
 
 /**
  * @brief Function to check whether the input command argument contains
           correct characters.
+ * @details A single isWordChar table load per byte replaces the earlier
+ * cascade of range compares, so the loop carries one well-predicted branch.
  * @retval true   If no character is out of the range of valid characters
  * @retval false  If any character is out of the range of valid characters
  */
 bool checkCorrectChars(const char* word) {
   for (; *word != '\0'; word++) {
-    int i = *word;
-    if (i >= 48 && i <= 57) continue;         // [0-9] valid
-    else if (i >= 65 && i <= 90) continue;    // [A-Z] valid
-    else if (i >= 97 && i <= 122) continue;   // [a-z] valid
-    else if (i == 39) continue;               // '(Apostrophe) cannot end word
-    else if (i == 0) continue;
-    else
-      return false;
+    if (!isWordChar[(unsigned char)*word]) return false;
   }
   return true;
 }
 
-/// @brief Class to implement vector type functionality.
-class myVector {
+/// @brief Delta + varint encoded list of increasing document indices.
+/// @details Occurrence indices are monotonically increasing, so only the
+/// gap to the previous occurrence is stored, encoded 7 bits per byte with
+/// the high bit marking continuation. Typical gaps fit in one or two bytes
+/// versus four for a raw int, so hot words' lists shrink 2-3x and locate
+/// streams far fewer cache lines.
+class indexStream {
  public:
-    int* arr;         ///< Member variable to store indices in array
+    uint8_t* bytes;   ///< Varint encoded deltas, one per recorded index.
     size_t capacity;  ///< Member variable to store alloced memory to data
-    size_t m_size;    ///< Member variable to store actual data in structure
+    size_t byteLen;   ///< Number of encoded bytes used in bytes.
+    size_t m_count;   ///< Number of indices recorded in the stream.
+    int last;         ///< Most recently recorded index, for delta encoding.
+    const uint8_t* cursorPtr;  ///< Decode cursor; NULL when invalidated.
+    size_t cursorPos;          ///< Number of deltas decoded at the cursor.
+    int cursorValue;           ///< Index value decoded at the cursor.
 
-    /// @brief Default constructor which sets all member pointers to NULL
-    myVector():arr(NULL), capacity(0), m_size(0) {}
+    /**
+     * @brief One argument constructor which anchors the delta encoding.
+     * @param start Index the first pushed delta is measured against.
+     */
+    explicit indexStream(int start)
+        :bytes(NULL), capacity(0), byteLen(0), m_count(0), last(start),
+        cursorPtr(NULL), cursorPos(0), cursorValue(0) {}
 
-    /// @brief Member function to return size of the data structure
+    /// @brief Member function to return the number of recorded indices.
     size_t size() {
-      return m_size;
+      return m_count;
     }
 
     /**
-     * @brief Member function to add an integer at the back of the data
-     structure
-     * @param idx Input index which is to be added.
+     * @brief Member function to record the next (larger) index.
+     * @param idx Input index which is to be appended.
      * @return Nothing
      */
-    void push_back(int idx) {
-      if (m_size + 1 > capacity) {
-        if (capacity == 0) {
-          capacity = 2;
-          arr = (int*)malloc(capacity*sizeof(int));
-          arr[m_size++] = idx;
-        } else {
-          capacity *= 2;
-          arr = (int*)realloc(arr, capacity*sizeof(int));
-          arr[m_size++] = idx;
-        }
-      } else {
-        arr[m_size++] = idx;
+    void push(int idx) {
+      uint32_t delta = (uint32_t)(idx - last);
+      last = idx;
+      while (delta >= 0x80) {
+        appendByte((uint8_t)(delta | 0x80));
+        delta >>= 7;
       }
+      appendByte((uint8_t)delta);
+      m_count++;
     }
 
     /**
-     * @brief Operator overload to provide array like acess to calling routine
-     * @param index Index of the data which is to be accessed.
-     * @return Data at the input index.
+     * @brief Static member function to decode one varint delta.
+     * @param p     Position in an encoded stream to decode from.
+     * @param value In/out running index; the decoded delta is added to it.
+     * @return Position of the next encoded delta.
      */
-    int operator[] (int index) {
-      return arr[index];
+    static const uint8_t* decodeNext(const uint8_t* p, int* value) {
+      uint32_t delta = 0;
+      int shift = 0;
+      uint8_t b;
+      do {
+        b = *p++;
+        delta |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+      *value += (int)delta;
+      return p;
+    }
+
+    /**
+     * @brief Member function to fetch the i-th recorded index.
+     * @param i     Zero-based position in the stream which is to be fetched.
+     * @param start Index the stream's first delta is measured against.
+     * @details Keeps a decode cursor across calls, so the common pattern of
+     * fetching positions in increasing order resumes where the previous
+     * fetch stopped - O(total) for a forward scan instead of O(N^2) restart
+     * decoding. The cursor rewinds only when an earlier position is asked
+     * for, and is invalidated when the backing storage moves on growth.
+     * @return The decoded index.
+     */
+    int decodeAt(size_t i, int start) {
+      // Defensive bound: an out-of-range position must never walk the decode
+      // cursor past the end of the byte stream, even though callers are
+      // expected to range-check against size() first.
+      if (__builtin_expect(i >= m_count, 0)) {
+        if (0 == m_count) return start;
+        i = m_count - 1;
+      }
+      if (NULL == cursorPtr || i + 1 < cursorPos) {
+        cursorPtr = bytes;
+        cursorValue = start;
+        cursorPos = 0;
+      }
+      while (cursorPos <= i) {
+        cursorPtr = decodeNext(cursorPtr, &cursorValue);
+        cursorPos++;
+      }
+      return cursorValue;
     }
 
     /// @brief Destructor for memory deallocation.
-    ~myVector() {
-      if (NULL != arr) free(arr);
+    ~indexStream() {
+      if (NULL != bytes) free(bytes);
+    }
+
+ private:
+    /// @brief Member function to append one encoded byte, growing as needed.
+    void appendByte(uint8_t b) {
+      if (__builtin_expect(byteLen == capacity, 0)) grow();
+      bytes[byteLen++] = b;
+    }
+
+    /// @brief Member function to grow the backing storage geometrically.
+    void grow() {
+      capacity = (capacity == 0) ? 8 : capacity * 2;
+      bytes = (uint8_t*)realloc(bytes, capacity);
+      cursorPtr = NULL;  // realloc may have moved the stream under the cursor
+    }
+};
+
+/// @brief Pool allocator which hands out fixed-size slots from large slabs.
+/// @details Objects are bump-allocated out of malloc'd slabs which start at
+/// 4KB and double up to 1MB. Individual objects are never freed; the whole
+/// pool is released in one sweep via reset(). This avoids one malloc/free
+/// pair per object and keeps objects packed on consecutive cache lines.
+template <typename T>
+class nodePool {
+ public:
+    /// @brief Header linking the allocated slabs so reset() can free them.
+    struct slab {
+      slab* next;  ///< Next older slab in the allocation list.
+    };
+    slab* slabs;      ///< List of allocated slabs, newest first.
+    char* cur;        ///< Bump pointer into the newest slab.
+    char* end;        ///< One past the last usable byte of the newest slab.
+    size_t slabSize;  ///< Payload size of the next slab to be allocated.
+
+    /// @brief Default constructor which starts with no slabs allocated.
+    nodePool():slabs(NULL), cur(NULL), end(NULL), slabSize(4096) {}
+
+    /**
+     * @brief Member function to hand out storage for one object of type T.
+     * @return Pointer to uninitialized storage; construct with placement new.
+     */
+    T* alloc() {
+      if (cur + sizeof(T) > end) grow();
+      T* ret = reinterpret_cast<T*>(cur);
+      cur += sizeof(T);
+      return ret;
+    }
+
+    /// @brief Member function to free every slab in one sweep.
+    void reset() {
+      while (NULL != slabs) {
+        slab* next = slabs->next;
+        free(slabs);
+        slabs = next;
+      }
+      cur = end = NULL;
+      slabSize = 4096;
+    }
+
+    /// @brief Destructor for memory deallocation.
+    ~nodePool() { reset(); }
+
+ private:
+    /// @brief Member function to allocate a fresh slab, doubling its size.
+    void grow() {
+      slab* s = (slab*)malloc(sizeof(slab) + slabSize);
+      s->next = slabs;
+      slabs = s;
+      cur = reinterpret_cast<char*>(s + 1);
+      end = cur + slabSize;
+      if (slabSize < (1 << 20)) slabSize *= 2;
+    }
+};
+
+/// @brief Bump allocator which packs word strings into large slabs.
+/// @details Strings are carved out of 64KB malloc'd slabs instead of one
+/// strdup per unique word, removing the per-string allocator header and
+/// keeping the vocabulary densely packed for the probe comparisons.
+/// Individual strings are never freed; reset() releases whole slabs.
+class stringArena {
+ public:
+    /// @brief Header linking the allocated slabs so reset() can free them.
+    struct slab {
+      slab* next;  ///< Next older slab in the allocation list.
+    };
+    slab* slabs;  ///< List of allocated slabs, newest first.
+    char* cur;    ///< Bump pointer into the newest slab.
+    char* end;    ///< One past the last usable byte of the newest slab.
+
+    /// @brief Default constructor which starts with no slabs allocated.
+    stringArena():slabs(NULL), cur(NULL), end(NULL) {}
+
+    /**
+     * @brief Member function to hand out n bytes of string storage.
+     * @param n Number of bytes needed, including the NUL terminator.
+     * @return Pointer to the reserved bytes.
+     */
+    char* alloc(size_t n) {
+      if (cur + n > end) grow(n);
+      char* ret = cur;
+      cur += n;
+      return ret;
+    }
+
+    /// @brief Member function to free every slab in one sweep.
+    void reset() {
+      while (NULL != slabs) {
+        slab* next = slabs->next;
+        free(slabs);
+        slabs = next;
+      }
+      cur = end = NULL;
+    }
+
+    /// @brief Destructor for memory deallocation.
+    ~stringArena() { reset(); }
+
+ private:
+    /// @brief Member function to allocate a fresh slab of at least n bytes.
+    void grow(size_t n) {
+      size_t payload = 64 * 1024;
+      if (n > payload) payload = n;
+      slab* s = (slab*)malloc(sizeof(slab) + payload);
+      s->next = slabs;
+      slabs = s;
+      cur = reinterpret_cast<char*>(s + 1);
+      end = cur + payload;
     }
 };
 
 /**
- * @brief Class to represent the node of a binary search tree.
+ * @brief Class to represent one word entry of the word table.
+ * @details Roughly half the vocabulary of natural text occurs exactly once,
+ * so the first occurrence index is stored inline and the growable extra
+ * vector (embedded by value, not heap-allocated) stays empty for those
+ * words. A singleton word therefore costs no index allocation at all.
  */
 class node {
  public:
-    node* left;       ///< Member Pointer to left subtree of this node.
-    node* right;      ///< Member Pointer to right subtree of this node.
-    char* word;       ///< Member for Word stored in this node.
-    myVector* index;  ///< Indices of this word in the input document
+    char* word;      ///< Member for Word stored in this node.
+    uint16_t len;    ///< Length of word in bytes, excluding the NUL.
+    int firstIndex;  ///< First index of this word in the input document.
+    indexStream extra;  ///< Indices of this word after the first.
 
-    /// @brief Default constructor which sets all member pointers to NULL
-    node():left(NULL), right(NULL), word(NULL), index(NULL) {}
+    /**
+     * @brief Three argument constructor for a word and its first index.
+     * @param word   Input word to be stored in this node.
+     * @param len    Length of the input word in bytes.
+     * @param index  Index at which the word first occurred.
+     */
+    node(char* word, uint16_t len, int index)
+        :word(word), len(len), firstIndex(index), extra(index) {}
 
     /**
-     * @brief One argument constructor with input argument to set word.
-     * @param word  Input word to be stored in this node.
+     * @brief Member function to record one more occurrence of this word.
+     * @param idx Input index which is to be added.
+     * @return Nothing
      */
-    node(char* word):left(NULL), right(NULL), word(word), index(new \
-    myVector()) {}
+    void addIndex(int idx) {
+      extra.push(idx);
+    }
 
-    /// @brief Destructor for memory deallocation.
-    ~node() {
-      if (NULL != word) free(word);
-      if (NULL != left) delete left;
-      if (NULL != right) delete right;
-      if (NULL != index)  delete index;
+    /// @brief Member function to return the number of recorded occurrences.
+    size_t count() {
+      return 1 + extra.size();
     }
-} *root;
+
+    /**
+     * @brief Member function to fetch the i-th occurrence index.
+     * @param i Zero-based occurrence number which is to be fetched.
+     * @return Index in the document of the i-th occurrence.
+     */
+    int indexAt(size_t i) {
+      return (0 == i) ? firstIndex : extra.decodeAt(i - 1, firstIndex);
+    }
+};
 
 /**
- * @brief Function to insert a word into binary search tree.
- * @param	word	word from the document which is to be inserted into the tree.
- * @param index Index at which this word was found in the document.
- * @return The new root of the binary search tree.
+ * @brief Function to fold a string to lower case in place.
+ * @param word  Input word which is to be folded; must be writable.
+ * @details Callers fold each token or query word exactly once before it
+ * reaches the word table, so the table stores lower case keys and every
+ * hash or comparison afterwards works on raw bytes.
+ * @return Nothing.
  */
-node* insert(node* root, const char* word, int index) {
-  if (root == NULL) {
-    root = new node(strdup(word));
-    root->index->push_back(index);
-    return root;
-  }
-  int rc = strcasecmp(word, root->word);
-  if (rc < 0) {
-    node* retNode = insert(root->left, word, index);
-    if (root->left == NULL) root->left = retNode;
-  } else if (rc > 0) {
-    node* retNode = insert(root->right, word, index);
-    if (root->right == NULL) root->right = retNode;
-  } else {
-    root->index->push_back(index);
+void toLowerStr(char* word) {
+  for (; *word != '\0'; word++) {
+    if (*word >= 'A' && *word <= 'Z') *word += 32;
   }
-  return root;
 }
 
 /**
- * @brief Function to lookup a word from the binary search tree.
- * @param	root	The root of the binary search tree in which the node is to be 
- * looked up.
- * @param word  The word which is to be looked for
- * @details The function returns if the input is NULL. If not it checks if the 
- * input word is equal to, less than or greater than the current node's word. 
- * If it's equal current node is returned. Otherwise the word is lookedup into
- * left subtree or right sub tree.
- * @return The node which contains the information for the query word. If it 
- * doesn't exist NULL is returned.
+ * @brief Function to hash a word.
+ * @param word  Input word which is to be hashed; expected lower case.
+ * @details Plain FNV-1a over the bytes of the word. Case folding happens
+ * once per token in the caller, not once per hashed byte.
+ * @return The hash value of the word.
  */
-node* lookup(node* root, const char* word) {
-  if (root == NULL) return NULL;
-  node* retNode = NULL;
-  int rc = strcasecmp(word, root->word);
-  if (rc < 0) retNode = lookup(root->left, word);
-  else if (rc > 0) retNode = lookup(root->right, word);
-  else
-    retNode = root;
-  return retNode;
+uint64_t hashWord(const char* word) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (; *word != '\0'; word++) {
+    hash = (hash ^ (unsigned char)*word) * 1099511628211ULL;
+  }
+  return hash;
 }
 
+/// @brief Class which owns one complete word table and its storage.
+/// @details Bundles the slot array, the node pool and the string arena so
+/// the whole locator state travels as one object instead of a set of file
+/// scope globals. This keeps the allocator pointers reachable through one
+/// base register in the hot paths and allows independent instances (for
+/// example one per worker thread in a parallel load).
+class wordLocator {
+ public:
+    node** table;          ///< Open-addressed hash table of word entries.
+    size_t tableCapacity;  ///< Number of slots in table; power of two.
+    size_t tableSize;      ///< Number of occupied slots in table.
+    nodePool<node> wordPool;  ///< Pool which owns the node storage.
+    stringArena wordArena;    ///< Arena which owns the word strings.
+
+    /// @brief Default constructor which starts with an empty table.
+    wordLocator():table(NULL), tableCapacity(0), tableSize(0) {}
+
+    /// @brief Destructor for memory deallocation.
+    ~wordLocator() { freeTable(); }
+
+    /**
+     * @brief Member function to grow the table to double its current capacity.
+     * @details All existing entries are rehashed into the new slot array with
+     * linear probing. Entries themselves are not copied; only the slot
+     * pointers move.
+     * @return Nothing.
+     */
+    void growTable() {
+      size_t newCapacity = (0 == tableCapacity) ? 1024 : tableCapacity * 2;
+      node** newTable = (node**)calloc(newCapacity, sizeof(node*));
+      for (size_t i = 0; i < tableCapacity; i++) {
+        if (NULL == table[i]) continue;
+        size_t j = hashWord(table[i]->word) & (newCapacity - 1);
+        while (NULL != newTable[j]) j = (j + 1) & (newCapacity - 1);
+        newTable[j] = table[i];
+      }
+      free(table);
+      table = newTable;
+      tableCapacity = newCapacity;
+    }
+
+    /**
+     * @brief Function to insert a word into the word table.
+     * @param	word	word from the document which is to be inserted.
+     * @param index Index at which this word was found in the document.
+     * @details Probes linearly from the word's hash slot. If the word is
+     * already present the index is appended to its occurrence list; otherwise
+     * a new entry is allocated from wordPool and placed in the first empty
+     * slot. The table is grown before the load factor reaches 0.7.
+     * @return The entry for the input word.
+     */
+    node* insert(const char* word, int index) {
+      if (tableSize * 10 >= tableCapacity * 7) growTable();
+      size_t wordLen = strlen(word);
+      size_t i = hashWord(word) & (tableCapacity - 1);
+      while (NULL != table[i]) {
+        if (table[i]->len == wordLen &&
+            0 == memcmp(word, table[i]->word, wordLen)) {
+          table[i]->addIndex(index);
+          return table[i];
+        }
+        i = (i + 1) & (tableCapacity - 1);
+      }
+      char* stored = wordArena.alloc(wordLen + 1);
+      memcpy(stored, word, wordLen + 1);
+      node* entry = new (wordPool.alloc())
+          node(stored, (uint16_t)wordLen, index);
+      table[i] = entry;
+      tableSize++;
+      return entry;
+    }
+
+    /**
+     * @brief Function to lookup a word in the word table.
+     * @param word  The word which is to be looked for
+     * @details Probes linearly from the word's hash slot until the word or
+     * an empty slot is found.
+     * @return The entry which contains the information for the query word.
+     * If it doesn't exist NULL is returned.
+     */
+    node* lookup(const char* word) {
+      if (NULL == table) return NULL;
+      size_t wordLen = strlen(word);
+      size_t i = hashWord(word) & (tableCapacity - 1);
+      while (NULL != table[i]) {
+        if (table[i]->len == wordLen &&
+            0 == memcmp(word, table[i]->word, wordLen)) return table[i];
+        i = (i + 1) & (tableCapacity - 1);
+      }
+      return NULL;
+    }
+
+    /**
+     * @brief Function to tear down the word table and release its entries.
+     * @details Runs the entry destructors to release per-entry heap memory,
+     * then frees the slot array and reclaims the entry storage via
+     * wordPool.reset().
+     * @return Nothing.
+     */
+    void freeTable() {
+      for (size_t i = 0; i < tableCapacity; i++) {
+        if (NULL != table[i]) table[i]->~node();
+      }
+      free(table);
+      table = NULL;
+      tableCapacity = 0;
+      tableSize = 0;
+      wordPool.reset();
+      wordArena.reset();
+    }
+
+    /**
+     * @brief Member function to tokenize one byte range into the table.
+     * @param p         First byte of the range which is to be tokenized.
+     * @param rangeEnd  One past the last byte of the range.
+     * @param startIdx  Document index to assign to the first token found.
+     * @details Walks the range once with the isWordChar table; each token is
+     * folded to lower case while being copied into a small stack buffer and
+     * handed to insert() with consecutive indices from startIdx.
+     * @return The number of tokens inserted.
+     */
+    int insertRange(const char* p, const char* rangeEnd, int startIdx) {
+      char wordBuf[512];
+      int idx = startIdx;
+      while (p < rangeEnd) {
+        while (p < rangeEnd && !isWordChar[(unsigned char)*p]) p++;
+        const char* tok = p;
+        while (p < rangeEnd && isWordChar[(unsigned char)*p]) p++;
+        size_t len = (size_t)(p - tok);
+        if (len == 0) break;
+        if (len >= sizeof(wordBuf)) len = sizeof(wordBuf) - 1;
+        memcpy(wordBuf, tok, len);
+        wordBuf[len] = '\0';
+        toLowerStr(wordBuf);
+        insert(wordBuf, idx);
+        idx++;
+      }
+      return idx - startIdx;
+    }
+
+    /**
+     * @brief Member function to fold another locator's words into this one.
+     * @param other Locator whose entries are to be merged in.
+     * @param base  Offset to add to every index coming from other.
+     * @details Each word's occurrence list in other is already in document
+     * order and all of other's indices fall after those merged previously,
+     * so appending each source list as a block keeps every occurrence list
+     * globally sorted.
+     * @return Nothing.
+     */
+    void merge(wordLocator& other, int base) {
+      for (size_t i = 0; i < other.tableCapacity; i++) {
+        node* src = other.table[i];
+        if (NULL == src) continue;
+        node* dst = insert(src->word, src->firstIndex + base);
+        int value = src->firstIndex;
+        const uint8_t* p = src->extra.bytes;
+        const uint8_t* streamEnd = p + src->extra.byteLen;
+        while (p < streamEnd) {
+          p = indexStream::decodeNext(p, &value);
+          dst->addIndex(value + base);
+        }
+      }
+    }
+
+    /**
+     * @brief Member function to load a document into the word table via mmap.
+     * @param path  Path of the document which is to be loaded.
+     * @details Maps the whole file read-only with MADV_SEQUENTIAL readahead.
+     * Small files are tokenized serially via insertRange(); larger files are
+     * split on token boundaries across worker threads, each of which builds
+     * a private wordLocator which is then merged back in shard order (see
+     * loadWorker()). Any previously loaded table is replaced only after the
+     * file has been mapped successfully.
+     * @retval true   If the document was loaded.
+     * @retval false  If the file could not be opened or mapped.
+     */
+    bool loadDocument(const char* path);
+};
+
+static wordLocator locator;  ///< The word table driven by main().
+
+static const int maxLoadThreads = 8;  ///< Upper bound on load worker threads.
+
+/// @brief Per-thread state for one shard of a parallel document load.
+struct loadShard {
+  const char* begin;  ///< First byte of this shard's range.
+  const char* end;    ///< One past the last byte of this shard's range.
+  int tokenCount;     ///< Number of tokens found; filled by the worker.
+  wordLocator local;  ///< Private word table built by the worker.
+};
+
 /**
- * @brief Function to do a inorder traversal on the binary search tree.
- * @param	root	The root of the binary search tree on which in order traversal 
- is to be done.
- * @return Nothing.
+ * @brief Thread routine to tokenize one shard into its private locator.
+ * @param arg Pointer to the loadShard this worker owns.
+ * @details Workers share nothing: each inserts into its own table, pool and
+ * arena with local indices starting at 1. The caller rebases the indices
+ * while merging, using the shard token counts.
+ * @return NULL always.
  */
-void inorder(node* root) {
-  if (root == NULL) return;
-  inorder(root->left);
-  wl_printf("%s ", root->word);
-  for (unsigned int i = 0; i < root->index->m_size; i++) {
-    wl_printf("%d ", (*root->index)[i]);
+static void* loadWorker(void* arg) {
+  loadShard* shard = (loadShard*)arg;
+  shard->tokenCount = shard->local.insertRange(shard->begin, shard->end, 1);
+  return NULL;
+}
+
+bool wordLocator::loadDocument(const char* path) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) return false;
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  const char* base = NULL;
+  if (size != 0) {
+    base = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    madvise((void*)base, size, MADV_SEQUENTIAL);
   }
-  wl_printf("\n");
-  inorder(root->right);
+  if (NULL != table) freeTable();
+  long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nThreads > maxLoadThreads) nThreads = maxLoadThreads;
+  if (nThreads < 2 || size < (1 << 20)) {
+    if (NULL != base) insertRange(base, base + size, 1);
+  } else {
+    loadShard shards[maxLoadThreads];
+    const char* prev = base;
+    for (long t = 0; t < nThreads; t++) {
+      const char* chunkEnd = base + (size * (size_t)(t + 1)) / nThreads;
+      if (t == nThreads - 1) {
+        chunkEnd = base + size;
+      } else {
+        // Never split a token: push the boundary past any word in progress.
+        while (chunkEnd < base + size && isWordChar[(unsigned char)*chunkEnd])
+          chunkEnd++;
+      }
+      shards[t].begin = prev;
+      shards[t].end = chunkEnd;
+      shards[t].tokenCount = 0;
+      prev = chunkEnd;
+    }
+    pthread_t tids[maxLoadThreads];
+    for (long t = 0; t < nThreads; t++)
+      pthread_create(&tids[t], NULL, loadWorker, &shards[t]);
+    for (long t = 0; t < nThreads; t++)
+      pthread_join(tids[t], NULL);
+    int ordinalBase = 0;
+    for (long t = 0; t < nThreads; t++) {
+      merge(shards[t].local, ordinalBase);
+      ordinalBase += shards[t].tokenCount;
+    }
+  }
+  if (NULL != base) munmap((void*)base, size);
+  close(fd);
+  return true;
 }
+
 #endif  // P1_WL_H_
@@ -35,6 +35,24 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
   this->bufMgr = bufMgrIn;
   this->attrByteOffset = attrByteOffset;
   this->attributeType = attrType;
+  this->currentPageData = NULL;
+  this->rootHasChildren = false;
+
+  // Bind the key-type dispatch once; every later call goes through the
+  // member pointers instead of re-switching on the attribute type.
+  switch (this->attributeType) {
+  case INTEGER:
+    bindDispatch<int>();
+    break;
+  case DOUBLE:
+    bindDispatch<double>();
+    break;
+  case STRING:
+    bindDispatch<char*>();
+    break;
+  default:
+    break;
+  }
 
   if (true == badgerdb::BlobFile::exists(indexName)) {
     this->file = new BlobFile(indexName, false);
@@ -60,42 +78,30 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
     memcpy(headerPage, &metaData, sizeof(IndexMetaInfo));
     this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
 
+    // Bulk load the relation instead of inserting one tuple at a time: the
+    // sorted records are written out as full pages bottom-up, so no page is
+    // ever split during construction.
     switch (this->attributeType) {
     case INTEGER:
-      createRoot<int>(rootPage);
+      bulkLoad<int>(relationName, rootPage);
       break;
     case DOUBLE:
-      createRoot<double>(rootPage);
+      bulkLoad<double>(relationName, rootPage);
       break;
     case STRING:
-      createRoot<char*>(rootPage);
+      bulkLoad<char*>(relationName, rootPage);
       break;
     default:
       break;
     }
-
-    {
-      FileScan fscan(relationName, bufMgr);
-      try
-      {
-        RecordId scanRid;
-        while(1)
-        {
-          fscan.scanNext(scanRid);
-          //Assuming RECORD.i is our key, lets extract the key, which we know is INTEGER and whose byte offset is also know inside the record.
-          std::string recordStr = fscan.getRecord();
-          const char *record = recordStr.c_str();
-          void* key = (void*)(record + this->attrByteOffset);
-          this->insertEntry(key, scanRid);
-#ifdef DEBUG
-          this->bufMgr->flushFile(this->file);
-#endif
-        }
-      }
-      catch(EndOfFileException e) { }
-    }
-    // filescan goes out of scope here, so relation file gets closed.
   }
+
+  // Keep the root resident for the life of the index: one extra pin taken
+  // here and dropped in the destructor means the top of every descent never
+  // loses the eviction race against streaming leaf reads. moveRootPin
+  // carries the pin along whenever the root page changes.
+  Page* rootKeep;
+  this->bufMgr->readPage(this->file, this->rootPageNum, rootKeep);
 }
 
 
@@ -105,6 +111,7 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 
 BTreeIndex::~BTreeIndex()
 {
+  this->bufMgr->unPinPage(this->file, this->rootPageNum, false);
   this->bufMgr->flushFile(this->file);
   delete this->file;
 }
@@ -113,39 +120,14 @@ BTreeIndex::~BTreeIndex()
 // BTreeIndex::insertEntry
 // -----------------------------------------------------------------------------
 
-const void BTreeIndex::insertEntry(const void *key, const RecordId rid) 
+const void BTreeIndex::insertEntry(const void *key, const RecordId rid)
 {
-  switch(this->attributeType) {
-  case INTEGER:
-    this->insertKeyTemplate<int>(key, rid);
-    break;
-  case DOUBLE:
-    this->insertKeyTemplate<double>(key, rid);
-    break;
-  case STRING:
-    this->insertKeyTemplate<char*>(key,rid);
-    break;
-  default:
-    break;
-  }
+  (this->*insertFn)(key, rid);
 }
 
 const bool BTreeIndex::deleteEntry(const void *key)
 {
-  switch(this->attributeType) {
-  case INTEGER:
-    return this->deleteKeyTemplate<int>(key);
-    break;
-  case DOUBLE:
-    return this->deleteKeyTemplate<double>(key);
-    break;
-  case STRING:
-    return this->deleteKeyTemplate<char*>(key);
-    break;
-  default:
-    break;
-  }
-  return false;
+  return (this->*deleteFn)(key);
 }
 
 // -----------------------------------------------------------------------------
@@ -175,25 +157,7 @@ const void BTreeIndex::startScan(const void* lowValParm,
     throw BadOpcodesException();
   }
 
-  switch (this->attributeType) {
-    case INTEGER:
-    {
-      this->startScanTemplate<int>(lowValParm, highValParm);
-      break;  
-    }
-    case DOUBLE:
-    {
-      this->startScanTemplate<double>(lowValParm, highValParm);
-      break;  
-    }
-    case STRING:
-    {
-      this->startScanTemplate<char*>(lowValParm, highValParm);
-      break;  
-    }
-    default:
-      break;
-  }
+  (this->*startScanFn)(lowValParm, highValParm);
 }
 
 // -----------------------------------------------------------------------------
@@ -203,25 +167,17 @@ const void BTreeIndex::startScan(const void* lowValParm,
 const void BTreeIndex::scanNext(RecordId& outRid) 
 {
   if(this->scanExecuting == false) throw ScanNotInitializedException();
-  switch (this->attributeType) {
-    case INTEGER:
-    {
-      this->scanNextTemplate<int>(outRid);
-      break;
-    }
-    case DOUBLE:
-    {
-      this->scanNextTemplate<double>(outRid);
-      break;
-    }
-    case STRING:
-    {
-      this->scanNextTemplate<char*>(outRid);
-      break;
-    }
-    default:
-      break;
-  }
+  (this->*scanNextFn)(outRid);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::scanNextBatch
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::scanNextBatch(RecordId* outRids, const int maxN)
+{
+  if(this->scanExecuting == false) throw ScanNotInitializedException();
+  return (this->*scanNextBatchFn)(outRids, maxN);
 }
 
 // -----------------------------------------------------------------------------
@@ -232,6 +188,12 @@ const void BTreeIndex::endScan()
 {
   if (this->scanExecuting == false) throw ScanNotInitializedException();
   this->scanExecuting = false;
+  // The scan keeps its current leaf pinned between scanNext calls; a scan
+  // abandoned before completion still holds that pin, so release it here.
+  if (this->currentPageData != NULL) {
+    this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+    this->currentPageData = NULL;
+  }
 }
 
 }
@@ -7,16 +7,20 @@
 
 #pragma once
 
-#include <iostream>
 #include <string>
 #include "string.h"
 #include <sstream>
 #include <vector>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "types.h"
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
+#include "filescan.h"
 #include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
@@ -32,6 +36,11 @@
 #ifdef DEBUG
 #include <iostream>
 //using namespace std;
+///Debug trace that streams to cout. Expands to nothing in normal builds, so
+///the hot paths carry no iostream dependency at all.
+#define BTREE_DBG(x) do { std::cout << x << std::endl; } while (0)
+#else
+#define BTREE_DBG(x) do {} while (0)
 #endif
 
 namespace badgerdb
@@ -63,41 +72,55 @@ enum Operator
  */
 const  int STRINGSIZE = 10;
 
+/**
+ * @brief Maximum supported height of the B+Tree. Used to size the fixed
+ * descent-path buffer recorded on the way down to a leaf; with fanouts in
+ * the hundreds a tree this tall is far beyond any file the buffer manager
+ * can address.
+ */
+const  int MAXTREEHEIGHT = 16;
+
+/**
+ * @brief How many entries before the end of a leaf a range scan fetches the
+ * right sibling into the buffer pool, so the page turn is a pool hit.
+ */
+const  int SCANPREFETCHDIST = 8;
+
 /**
  * @brief Number of key slots in B+Tree leaf for INTEGER key.
  */
-//                                                  sibling ptr             key               rid
-const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+//                                                  sibling ptr    slot count          key               rid
+const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) - sizeof( int ) ) / ( sizeof( int ) + sizeof( RecordId ) );
 
 /**
  * @brief Number of key slots in B+Tree leaf for DOUBLE key.
  */
-//                                                     sibling ptr               key               rid
-const  int DOUBLEARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( RecordId ) );
+//                                                     sibling ptr    slot count            key               rid
+const  int DOUBLEARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) - sizeof( int ) ) / ( sizeof( double ) + sizeof( RecordId ) );
 
 /**
  * @brief Number of key slots in B+Tree leaf for STRING key.
  */
-//                                                    sibling ptr           key                      rid
-const  int STRINGARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( 10 * sizeof(char) + sizeof( RecordId ) );
+//                                                    sibling ptr    slot count        key                      rid
+const  int STRINGARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) - sizeof( int ) ) / ( 10 * sizeof(char) + sizeof( RecordId ) );
 
 /**
  * @brief Number of key slots in B+Tree non-leaf for INTEGER key.
  */
-//                                                     level     extra pageNo                  key       pageNo
-const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
+//                                                     level    slot count   extra pageNo                  key       pageNo
+const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
 
 /**
  * @brief Number of key slots in B+Tree leaf for DOUBLE key.
  */
-//                                                        level        extra pageNo                 key            pageNo   -1 due to structure padding
-const  int DOUBLEARRAYNONLEAFSIZE = (( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( PageId ) )) - 1;
+//                                                        level    slot count    extra pageNo                 key            pageNo   -1 due to structure padding
+const  int DOUBLEARRAYNONLEAFSIZE = (( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( PageId ) )) - 1;
 
 /**
  * @brief Number of key slots in B+Tree leaf for STRING key.
  */
-//                                                        level        extra pageNo             key                   pageNo
-const  int STRINGARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( 10 * sizeof(char) + sizeof( PageId ) );
+//                                                        level    slot count    extra pageNo             key                   pageNo
+const  int STRINGARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) ) / ( 10 * sizeof(char) + sizeof( PageId ) );
 
 /**
  * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that 
@@ -145,6 +168,20 @@ bool operator<( const RIDKeyPair<T>& r1, const RIDKeyPair<T>& r2 )
 		return r1.rid.page_number < r2.rid.page_number;
 }
 
+/**
+ * @brief Branchless specialization for integer keys. Key and rid page number
+ * are packed into one 64-bit value, with the key biased into unsigned range
+ * so signed order is preserved, and compared with a single unsigned compare
+ * instead of the two-branch chain of the generic version.
+*/
+template <>
+inline bool operator<( const RIDKeyPair<int>& r1, const RIDKeyPair<int>& r2 )
+{
+	std::uint64_t p1 = (std::uint64_t(std::uint32_t(r1.key) ^ 0x80000000u) << 32) | r1.rid.page_number;
+	std::uint64_t p2 = (std::uint64_t(std::uint32_t(r2.key) ^ 0x80000000u) << 32) | r2.rid.page_number;
+	return p1 < p2;
+}
+
 /**
  * @brief The meta page, which holds metadata for Index file, is always first page of the btree index file and is cast
  * to the following structure to store or retrieve information from it.
@@ -191,6 +228,12 @@ struct NonLeafNodeInt{
    */
 	int level;
 
+  /**
+   * Number of keys currently stored in keyArray. The node has one more child
+   * page than keys, so end-of-records checks can stay off pageNoArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -211,6 +254,12 @@ struct NonLeafNodeDouble{
    */
 	int level;
 
+  /**
+   * Number of keys currently stored in keyArray. The node has one more child
+   * page than keys, so end-of-records checks can stay off pageNoArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -231,6 +280,12 @@ struct NonLeafNodeString{
    */
 	int level;
 
+  /**
+   * Number of keys currently stored in keyArray. The node has one more child
+   * page than keys, so end-of-records checks can stay off pageNoArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -246,6 +301,20 @@ struct NonLeafNodeString{
  * @brief Structure for all leaf nodes when the key is of INTEGER type.
 */
 struct LeafNodeInt{
+  /**
+   * Page number of the leaf on the right side.
+	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
+	 * Kept at the front with slotUse so the scan's page-turn fields share the
+	 * first cache line with the leading keys.
+   */
+	PageId rightSibPageNo;
+
+  /**
+   * Number of entries currently stored in this leaf, so end-of-records checks
+   * can stay off ridArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -255,18 +324,25 @@ struct LeafNodeInt{
    * Stores RecordIds.
    */
 	RecordId ridArray[ INTARRAYLEAFSIZE ];
+};
 
+/**
+ * @brief Structure for all leaf nodes when the key is of DOUBLE type.
+*/
+struct LeafNodeDouble{
   /**
    * Page number of the leaf on the right side.
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
+	 * Kept at the front with slotUse, as in LeafNodeInt.
    */
 	PageId rightSibPageNo;
-};
 
-/**
- * @brief Structure for all leaf nodes when the key is of DOUBLE type.
-*/
-struct LeafNodeDouble{
+  /**
+   * Number of entries currently stored in this leaf, so end-of-records checks
+   * can stay off ridArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -276,18 +352,25 @@ struct LeafNodeDouble{
    * Stores RecordIds.
    */
 	RecordId ridArray[ DOUBLEARRAYLEAFSIZE ];
+};
 
+/**
+ * @brief Structure for all leaf nodes when the key is of STRING type.
+*/
+struct LeafNodeString{
   /**
    * Page number of the leaf on the right side.
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
+	 * Kept at the front with slotUse, as in LeafNodeInt.
    */
 	PageId rightSibPageNo;
-};
 
-/**
- * @brief Structure for all leaf nodes when the key is of STRING type.
-*/
-struct LeafNodeString{
+  /**
+   * Number of entries currently stored in this leaf, so end-of-records checks
+   * can stay off ridArray.
+   */
+	int slotUse;
+
   /**
    * Stores keys.
    */
@@ -297,12 +380,6 @@ struct LeafNodeString{
    * Stores RecordIds.
    */
 	RecordId ridArray[ STRINGARRAYLEAFSIZE ];
-
-  /**
-   * Page number of the leaf on the right side.
-	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
-   */
-	PageId rightSibPageNo;
 };
 
 /**
@@ -366,6 +443,45 @@ class BTreeIndex {
    */
 	int		nextEntry;
 
+  /**
+   * Number of valid entries in the current leaf being scanned. Cached whenever a
+   * leaf is pinned for the scan so that the end-of-records checks stay on the key
+   * array and never have to probe ridArray for an INVALID_NUMBER sentinel.
+   */
+	int		currentPageOcc;
+
+  /**
+   * Index of the first entry on the current leaf the scan must not return,
+   * computed once per page visit with the vectorized upper-bound search.
+   * The per-tuple check in scanNext reduces to one integer compare.
+   */
+	int		currentPageStop;
+
+  /**
+   * True when currentPageStop was capped by the scan's upper bound rather
+   * than by page occupancy: reaching it completes the scan instead of
+   * turning to the right sibling.
+   */
+	bool	currentStopAtBound;
+
+  /**
+   * True once the root has child pages. The empty-tree check in the insert
+   * path only consults the root page until this flips, after which the
+   * common case skips the branch on a plain member read.
+   */
+	bool	rootHasChildren;
+
+  /**
+   * Key-type-specific entry points, bound once in the constructor so the
+   * public calls reach the right template instantiation through a single,
+   * well-predicted indirect call instead of a switch on attributeType.
+   */
+	const void (BTreeIndex::*insertFn)(const void* key, const RecordId rid);
+	const bool (BTreeIndex::*deleteFn)(const void* key);
+	const void (BTreeIndex::*startScanFn)(const void* lowVal, const void* highVal);
+	const void (BTreeIndex::*scanNextFn)(RecordId& outRid);
+	const int (BTreeIndex::*scanNextBatchFn)(RecordId* outRids, const int maxN);
+
   /**
    * Page number of current page being scanned.
    */
@@ -387,9 +503,10 @@ class BTreeIndex {
 	double	lowValDouble;
 
   /**
-   * Low STRING value for scan.
+   * Low STRING value for scan. Stored inline at key width so scan compares
+   * run strncmp straight on the buffer without a heap-backed std::string.
    */
-	std::string	lowValString;
+	char	lowValString[STRINGSIZE];
 
   /**
    * High INTEGER value for scan.
@@ -402,9 +519,9 @@ class BTreeIndex {
 	double	highValDouble;
 
   /**
-   * High STRING value for scan.
+   * High STRING value for scan. Stored inline like lowValString.
    */
-	std::string highValString;
+	char highValString[STRINGSIZE];
 	
   /**
    * Low Operator. Can only be GT(>) or GTE(>=).
@@ -485,6 +602,21 @@ class BTreeIndex {
 	const void scanNext(RecordId& outRid);  // returned record id
 
 
+  /**
+	 * Fetch up to maxN record ids of the next index entries that match the scan.
+	 * The contiguous run of qualifying entries on the current page is copied out in one memcpy
+	 * after a single vectorized upper-bound search, so the per-record bound check of scanNext
+	 * runs once per page visit instead of once per record. Pages are turned like scanNext.
+   * @param outRids	Array of at least maxN RecordIds filled with the next matching records
+   * @param maxN	Maximum number of records to return
+   * @return Number of RecordIds written to outRids; at least 1 when maxN is
+   * positive, 0 when maxN <= 0
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const int scanNextBatch(RecordId* outRids, const int maxN);
+
+
   /**
 	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
 	 * @throws ScanNotInitializedException If no scan has been initialized.
@@ -504,20 +636,65 @@ private:
 	const void startScanTemplate(const void* lowVal, const void* highVal);
 
 	///@brief Templated routine with keyType as template parameter for call from scanNext routine.
+	///Marked hot so the compiler groups it with the other scan/insert bodies and optimizes more aggressively.
   template <typename keyType, typename traits=keyTraits<keyType> >
-  const void scanNextTemplate(RecordId& outRid);
+  __attribute__((hot)) const void scanNextTemplate(RecordId& outRid);
+
+	///@brief Templated routine with keyType as template parameter for call from scanNextBatch routine.
+  template <typename keyType, typename traits=keyTraits<keyType> >
+  const int scanNextBatchTemplate(RecordId* outRids, const int maxN);
+
+	///@brief Recomputes currentPageStop and currentStopAtBound for the leaf the scan just entered.
+  template <typename keyType, typename traits=keyTraits<keyType> >
+  void computeScanStop();
 
   ///@brief Templated routine with keyType as template parameter for call from insertKeyTemplate routine.
 	template <typename keyType, typename traits=keyTraits<keyType> >
-  void getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage, PageId& pageNo, int& insertAt, int& endOfRecordsOffset, PageId& lastPageNo, bool insert = true);
+  void getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage, PageId& pageNo, int& insertAt, int& endOfRecordsOffset, PageId& lastPageNo, Page*& leafPage);
+
+	///@brief Binds the dispatch pointers to the instantiations for keyType. Called once from the constructor.
+	template <typename keyType, typename traits=keyTraits<keyType> >
+	void bindDispatch() {
+	  this->insertFn = &BTreeIndex::insertKeyTemplate<keyType>;
+	  this->deleteFn = &BTreeIndex::deleteKeyTemplate<keyType>;
+	  this->startScanFn = &BTreeIndex::startScanTemplate<keyType>;
+	  this->scanNextFn = &BTreeIndex::scanNextTemplate<keyType>;
+	  this->scanNextBatchFn = &BTreeIndex::scanNextBatchTemplate<keyType>;
+	}
+
+	///@brief Moves the resident pin that keeps the root page in the buffer pool
+	///from the previous root to the current rootPageNum. The extra pin, taken in
+	///the constructor and released in the destructor, keeps the top of the
+	///navigation path from ever losing the eviction race against streaming leaf
+	///reads. Every site that changes rootPageNum calls this with the old number.
+	void moveRootPin(const PageId oldRootPageNo)
+	{
+	  if (oldRootPageNo == this->rootPageNum) return;
+	  Page* keepPage;
+	  this->bufMgr->readPage(this->file, this->rootPageNum, keepPage);
+	  this->bufMgr->unPinPage(this->file, oldRootPageNo, false);
+	}
+
+	///@brief Read-only descent to the leaf and slot where a scan for key begins. Never records a path or splits.
+	template <typename keyType, typename traits=keyTraits<keyType> >
+	void findLeafForScan(const void* key, Page* rootPage, PageId& pageNo, int& startAt);
+
+	///@brief Descends one interior level towards the key, recording the step in the descent path.
+	template <typename keyType, typename traits=keyTraits<keyType> >
+	void descendOne(BufMgr* const bm, File* const fp, keyType keyValue, typename traits::nonLeafType*& currPage, PageId& lastPage, std::pair<int,PageId>* pathOfTraversal, int& pathDepth);
 
 	///@brief Templated routine with keyType as template parameter for call from constructor.
 	template <typename keyType, typename traits=keyTraits<keyType> >
 	void createRoot(Page*& rootPage);
 
+	///@brief Templated routine with keyType as template parameter for building the initial index from a relation in one pass.
+	template <typename keyType, typename traits=keyTraits<keyType> >
+	void bulkLoad(const std::string& relationName, Page*& rootPage);
+
 	///@brief Templated routine with keyType as template parameter for call from insertKey routine.
+	///Marked hot like scanNextTemplate.
   template <typename keyType, typename traits=keyTraits<keyType> >
-  const void insertKeyTemplate(const void* key, const RecordId rid);
+  __attribute__((hot)) const void insertKeyTemplate(const void* key, const RecordId rid);
 
   ///@brief Templated routine with keyType as template parameter for call from deleteKey routine.
   template <typename keyType, typename traits=keyTraits<keyType> >
@@ -573,8 +750,8 @@ public:
    static const int LEAFSIZE = INTARRAYLEAFSIZE;
    static const int NONLEAFSIZE = INTARRAYNONLEAFSIZE;
    static void setScanBounds(BTreeIndex* index, const void* lowValParm, const void* highValParm) {
-     index->lowValInt = *reinterpret_cast<int*>(const_cast<void*>(lowValParm));
-     index->highValInt = *reinterpret_cast<int*>(const_cast<void*>(highValParm));
+     memcpy(&index->lowValInt, lowValParm, sizeof(int));
+     memcpy(&index->highValInt, highValParm, sizeof(int));
      if (index->lowValInt > index->highValInt) throw BadScanrangeException();
    }
 
@@ -610,8 +787,87 @@ public:
         a = b;
    }
 
+   ///@brief Owning key representation used while sorting records for bulk load.
+   typedef int sortType;
+
+   static int toSortKey(const void* key) {
+     return getKeyValue(key);
+   }
+
+   static int fromSortKey(const sortType& v) {
+     return v;
+   }
+
    static int getKeyValue(const void* key) {
-      return *reinterpret_cast<int*>(const_cast<void*>(key));
+      // memcpy instead of a cast-and-deref: same single load, but well
+      // defined under strict aliasing so the value can stay in a register.
+      int keyValue;
+      memcpy(&keyValue, key, sizeof(int));
+      return keyValue;
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than v.
+    * @details Branchless binary search over the sorted key prefix. The ternaries
+    * compile to conditional moves, so the loop runs a fixed log2(n) steps with no
+    * mispredictable branches, and both candidate midpoints of the next step are
+    * prefetched to hide the dependent load latency.
+    */
+   static inline int findFirstGreater(const int* keys, int n, int v) {
+     int low = 0, high = n;
+     while (high - low > 16) {
+       int mid = (low + high) >> 1;
+       __builtin_prefetch(&keys[(low + mid) >> 1]);
+       __builtin_prefetch(&keys[(mid + 1 + high) >> 1]);
+       low = (keys[mid] <= v) ? mid+1 : low;
+       high = (keys[mid] <= v) ? high : mid;
+     }
+     // Once the window fits in a cache line, a branch-free counting scan beats
+     // further halving: the keys are sorted, so the count of keys less than or
+     // equal to v inside the window is the distance to the first greater key.
+     int idx = low;
+     int i = low;
+#ifdef __SSE2__
+     // Count four keys per compare: one packed greater-than plus a popcount
+     // of the lanes that stay within bound.
+     const __m128i vv = _mm_set1_epi32(v);
+     for (; i + 4 <= high; i += 4) {
+       __m128i kv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&keys[i]));
+       int gtMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(kv, vv)));
+       idx += 4 - __builtin_popcount(gtMask);
+     }
+#endif
+     for (; i < high; i++) idx += (keys[i] <= v) ? 1 : 0;
+     return idx;
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than or equal to v.
+    * @details Same branchless binary search as findFirstGreater.
+    */
+   static inline int findFirstGreaterEq(const int* keys, int n, int v) {
+     int low = 0, high = n;
+     while (high - low > 16) {
+       int mid = (low + high) >> 1;
+       __builtin_prefetch(&keys[(low + mid) >> 1]);
+       __builtin_prefetch(&keys[(mid + 1 + high) >> 1]);
+       low = (keys[mid] < v) ? mid+1 : low;
+       high = (keys[mid] < v) ? high : mid;
+     }
+     int idx = low;
+     int i = low;
+#ifdef __SSE2__
+     // Same four-wide counting tail as findFirstGreater, counting keys
+     // strictly below v.
+     const __m128i vv = _mm_set1_epi32(v);
+     for (; i + 4 <= high; i += 4) {
+       __m128i kv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&keys[i]));
+       int ltMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vv, kv)));
+       idx += __builtin_popcount(ltMask);
+     }
+#endif
+     for (; i < high; i++) idx += (keys[i] < v) ? 1 : 0;
+     return idx;
    }
 };
 
@@ -624,8 +880,8 @@ public:
    static const int LEAFSIZE = DOUBLEARRAYLEAFSIZE;
    static const int NONLEAFSIZE = DOUBLEARRAYNONLEAFSIZE;
    static void setScanBounds(BTreeIndex* index, const void* lowValParm, const void* highValParm) {
-     index->lowValDouble = *reinterpret_cast<double*>(const_cast<void*>(lowValParm));
-     index->highValDouble = *reinterpret_cast<double*>(const_cast<void*>(highValParm));
+     memcpy(&index->lowValDouble, lowValParm, sizeof(double));
+     memcpy(&index->highValDouble, highValParm, sizeof(double));
      if (index->lowValDouble > index->highValDouble) throw BadScanrangeException();
    }
 
@@ -661,8 +917,75 @@ public:
         a = b;
    }
 
+   ///@brief Owning key representation used while sorting records for bulk load.
+   typedef double sortType;
+
+   static double toSortKey(const void* key) {
+     return getKeyValue(key);
+   }
+
+   static double fromSortKey(const sortType& v) {
+     return v;
+   }
+
    static double getKeyValue(const void* key) {
-      return *reinterpret_cast<double*>(const_cast<void*>(key));
+      double keyValue;
+      memcpy(&keyValue, key, sizeof(double));
+      return keyValue;
+   }
+
+   /**
+    * @brief Maps a non-NaN double to an unsigned integer with the same total
+    * order: positives get the sign bit flipped, negatives are inverted whole.
+    * @details Index keys are never NaN, so the search compares can run on the
+    * integer pipes instead of the higher-latency FP compare. The only
+    * difference from the FP order is that -0.0 sorts strictly below +0.0.
+    */
+   static inline std::uint64_t toSortableBits(double d) {
+     std::uint64_t u;
+     memcpy(&u, &d, sizeof(u));
+     return u ^ (static_cast<std::uint64_t>(-static_cast<std::int64_t>(u >> 63)) | 0x8000000000000000ULL);
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than v.
+    * @details Same branchless prefetching binary search as the int
+    * specialization, with each key viewed through toSortableBits so every
+    * compare in the loop is an integer compare.
+    */
+   static inline int findFirstGreater(const double* keys, int n, double v) {
+     const std::uint64_t probe = toSortableBits(v);
+     int low = 0, high = n;
+     while (high - low > 8) {
+       int mid = (low + high) >> 1;
+       __builtin_prefetch(&keys[(low + mid) >> 1]);
+       __builtin_prefetch(&keys[(mid + 1 + high) >> 1]);
+       low = (toSortableBits(keys[mid]) <= probe) ? mid+1 : low;
+       high = (toSortableBits(keys[mid]) <= probe) ? high : mid;
+     }
+     // Finish inside the cache-line sized window with a branch-free counting scan.
+     int idx = low;
+     for (int i = low; i < high; i++) idx += (toSortableBits(keys[i]) <= probe) ? 1 : 0;
+     return idx;
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than or equal to v.
+    * @details Same sortable-bits binary search as findFirstGreater.
+    */
+   static inline int findFirstGreaterEq(const double* keys, int n, double v) {
+     const std::uint64_t probe = toSortableBits(v);
+     int low = 0, high = n;
+     while (high - low > 8) {
+       int mid = (low + high) >> 1;
+       __builtin_prefetch(&keys[(low + mid) >> 1]);
+       __builtin_prefetch(&keys[(mid + 1 + high) >> 1]);
+       low = (toSortableBits(keys[mid]) < probe) ? mid+1 : low;
+       high = (toSortableBits(keys[mid]) < probe) ? high : mid;
+     }
+     int idx = low;
+     for (int i = low; i < high; i++) idx += (toSortableBits(keys[i]) < probe) ? 1 : 0;
+     return idx;
    }
 };
 
@@ -675,16 +998,16 @@ public:
    static const int LEAFSIZE = STRINGARRAYLEAFSIZE;
    static const int NONLEAFSIZE = STRINGARRAYNONLEAFSIZE;
    static void setScanBounds(BTreeIndex* index, const void* lowValParm, const void* highValParm) {
-     index->lowValString = std::string(reinterpret_cast<char*>(const_cast<void*>(lowValParm)));
-     index->highValString = std::string(reinterpret_cast<char*>(const_cast<void*>(highValParm)));
-     if (index->lowValString > index->highValString) throw BadScanrangeException();
+     strncpy(index->lowValString, reinterpret_cast<const char*>(lowValParm), STRINGSIZE);
+     strncpy(index->highValString, reinterpret_cast<const char*>(highValParm), STRINGSIZE);
+     if (strncmp(index->lowValString, index->highValString, STRINGSIZE) > 0) throw BadScanrangeException();
    }
 
-   static inline std::string getLowBound(BTreeIndex* index) {
+   static inline char* getLowBound(BTreeIndex* index) {
      return index->lowValString;
    }
 
-   static inline std::string getUpperBound(BTreeIndex* index) {
+   static inline char* getUpperBound(BTreeIndex* index) {
      return index->highValString;
    }
 
@@ -692,10 +1015,6 @@ public:
      return strncmp(a,b,STRINGSIZE) < 0 ? true : false;
    }
 
-   static bool great(char* a, std::string b) {
-     return strncmp(a,b.c_str(),STRINGSIZE) > 0 ? true : false;
-   }
-
    static bool great(char* a, char* b) {
      return strncmp(a,b,STRINGSIZE) > 0 ? true : false;
    }
@@ -704,18 +1023,10 @@ public:
      return strncmp(a,b,STRINGSIZE) <= 0 ? true : false;
    }
 
-   static bool greatE(char* a, std::string b) {
-     return strncmp(a,b.c_str(),STRINGSIZE) >= 0 ? true : false;
-   }
-
    static bool greatE(char* a, char* b) {
      return strncmp(a,b,STRINGSIZE) >= 0 ? true : false;
    }
 
-   static bool equal(char* a, std::string b) {
-     return strncmp(a,b.c_str(),STRINGSIZE) == 0 ? true : false;
-   }
-
    static bool equal(char* a, char* b) {
      return strncmp(a,b,STRINGSIZE) == 0 ? true : false;
    }
@@ -723,12 +1034,85 @@ public:
    static void assign(char* a, char* b) {
       if (a == NULL) return;
       if (b != NULL) strncpy(a,b,STRINGSIZE);
-      else strcpy(a,""); 
+      else strcpy(a,"");
+   }
+
+   ///@brief Owning key representation used while sorting records for bulk load.
+   ///The record buffer a key points into dies with its FileScan iteration, so
+   ///the sort copy owns its characters. Truncated to STRINGSIZE so the sort
+   ///order matches the strncmp compares used on the pages.
+   typedef std::string sortType;
+
+   static std::string toSortKey(const void* key) {
+     const char* keyStr = reinterpret_cast<const char*>(key);
+     return std::string(keyStr, strnlen(keyStr, STRINGSIZE));
+   }
+
+   static char* fromSortKey(const sortType& v) {
+     return const_cast<char*>(v.c_str());
    }
 
    static char* getKeyValue(const void* key) {
      return reinterpret_cast<char*>(const_cast<void*>(key));
    }
+
+   /**
+    * @brief Compares the first STRINGSIZE bytes of two keys with one wide load
+    * per side instead of the byte loop inside strncmp.
+    * @details Differences past the key width are masked off, so the 16-byte
+    * loads may safely take in the neighbouring slot bytes inside the node.
+    * assign NUL-pads page keys, which keeps the byte-wise result identical to
+    * strncmp. Both arguments must have 16 readable bytes; user-supplied keys
+    * go through the padded probe copy in the search routines below.
+    */
+   static inline int compareKeys(const char* a, const char* b) {
+#ifdef __SSE2__
+     __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+     __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+     unsigned diffMask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+     int diff = __builtin_ctz(diffMask | 0x10000u);
+     if (diff >= STRINGSIZE) return 0;
+     return (static_cast<unsigned char>(a[diff]) < static_cast<unsigned char>(b[diff])) ? -1 : 1;
+#else
+     return strncmp(a, b, STRINGSIZE);
+#endif
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than v.
+    * @details Binary search over the sorted key prefix. The probe key is
+    * copied once into a padded buffer so every compare in the loop is a
+    * single pair of 16-byte loads.
+    */
+   static inline int findFirstGreater(const char keys[][STRINGSIZE], int n, char* v) {
+     char probe[16];
+     memset(probe, 0, sizeof(probe));
+     strncpy(probe, v, STRINGSIZE);
+     int low = 0, high = n;
+     while (low < high) {
+       int mid = (low + high) >> 1;
+       if (compareKeys(keys[mid], probe) <= 0) low = mid+1;
+       else high = mid;
+     }
+     return low;
+   }
+
+   /**
+    * @brief Returns the index of the first key in keys[0,n) which is greater than or equal to v.
+    * @details Same padded-probe binary search as findFirstGreater.
+    */
+   static inline int findFirstGreaterEq(const char keys[][STRINGSIZE], int n, char* v) {
+     char probe[16];
+     memset(probe, 0, sizeof(probe));
+     strncpy(probe, v, STRINGSIZE);
+     int low = 0, high = n;
+     while (low < high) {
+       int mid = (low + high) >> 1;
+       if (compareKeys(keys[mid], probe) < 0) low = mid+1;
+       else high = mid;
+     }
+     return low;
+   }
 };
 
 /**
@@ -737,161 +1121,336 @@ public:
 template<typename keyType, typename traits>
 void BTreeIndex::createRoot(Page*& rootPage) {
   typedef typename traits::nonLeafType nonLeafType;
-  nonLeafType rootData;
-  memset(&rootData, 0, sizeof(nonLeafType));
-  rootData.level = 1;
-  memcpy(rootPage, &rootData, sizeof(nonLeafType));
+  // Write the few fields readers actually consult instead of zeroing and
+  // copying a whole page image: slotUse bounds every key/child access, and
+  // pageNoArray[0] is the explicit empty-root marker the insert path tests.
+  nonLeafType* rootData = reinterpret_cast<nonLeafType*>(rootPage);
+  rootData->level = 1;
+  rootData->pageNoArray[0] = Page::INVALID_NUMBER;
+  rootData->slotUse = 0;
   this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
 }
 
+/**
+ * @brief Builds the initial index from a relation in a single pass.
+ * @details All (key, rid) pairs are scanned out of the relation, sorted, and
+ * written as leaves at maximum fill from left to right. The interior levels
+ * are then built bottom up, with the first key of each right-hand node as the
+ * separator, until one node's worth of children remains; that last layer goes
+ * into the pre-allocated root page. No page is ever split or revisited, so
+ * construction does one sort plus one sequential write instead of a descent
+ * and possible split per record. Falls back to an empty root when the
+ * relation has no tuples.
+ * @param relationName Relation whose tuples are to be indexed.
+ * @param rootPage The pinned page allocated for the root by the constructor.
+ */
 template<typename keyType, typename traits>
-void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage, PageId& pageNo, int& insertAt, int& endOfRecordsOffset, PageId& lastPageNo, bool insert)
-{
+void BTreeIndex::bulkLoad(const std::string& relationName, Page*& rootPage) {
   typedef typename traits::leafType leafType;
   typedef typename traits::nonLeafType nonLeafType;
-  int i = 0, depth = 1;
-  keyType keyValue = traits::getKeyValue(key);
+  typedef typename traits::sortType sortType;
+  std::vector<RIDKeyPair<sortType> > items;
+  {
+    FileScan fscan(relationName, this->bufMgr);
+    try {
+      RecordId scanRid;
+      while (1) {
+        fscan.scanNext(scanRid);
+        std::string recordStr = fscan.getRecord();
+        const char* record = recordStr.c_str();
+        RIDKeyPair<sortType> item;
+        item.set(scanRid, traits::toSortKey(record + this->attrByteOffset));
+        items.push_back(item);
+      }
+    }
+    catch(EndOfFileException e) { }
+  }
+  if (items.empty()) {
+    createRoot<keyType, traits>(rootPage);
+    return;
+  }
+  std::sort(items.begin(), items.end());
+
+  // Write the leaf level left to right at maximum fill, chaining the sibling
+  // pointers as each next page number becomes known.
+  int n = (int)items.size();
+  std::vector<std::pair<sortType, PageId>> level;
+  level.reserve((n + traits::LEAFSIZE - 1) / traits::LEAFSIZE);
+  leafType* prevLeaf = NULL;
+  PageId prevLeafNo = Page::INVALID_NUMBER;
+  for (int start = 0; start < n; start += traits::LEAFSIZE) {
+    PageId leafPageNo;
+    Page* leafPage;
+    this->bufMgr->allocPage(this->file, leafPageNo, leafPage);
+    leafType* dataPage = reinterpret_cast<leafType*>(leafPage);
+    int count = std::min(traits::LEAFSIZE, n - start);
+    for (int j = 0; j < count; j++) {
+      traits::assign(dataPage->keyArray[j], traits::fromSortKey(items[start+j].key));
+      dataPage->ridArray[j] = items[start+j].rid;
+    }
+    dataPage->slotUse = count;
+    dataPage->rightSibPageNo = Page::INVALID_NUMBER;
+    if (prevLeaf != NULL) {
+      prevLeaf->rightSibPageNo = leafPageNo;
+      this->bufMgr->unPinPage(this->file, prevLeafNo, true);
+    }
+    prevLeaf = dataPage;
+    prevLeafNo = leafPageNo;
+    level.push_back(std::pair<sortType, PageId>(items[start].key, leafPageNo));
+  }
+  this->bufMgr->unPinPage(this->file, prevLeafNo, true);
+
+  // Build interior levels until the children of one node remain. A node with
+  // c children carries c-1 keys: the first key of every child except the
+  // leftmost, matching the separators the split path would have pushed up.
+  int nodeLevel = 2;
+  while ((int)level.size() > traits::NONLEAFSIZE + 1) {
+    std::vector<std::pair<sortType, PageId>> upperLevel;
+    int nChildren = (int)level.size();
+    upperLevel.reserve((nChildren + traits::NONLEAFSIZE) / (traits::NONLEAFSIZE + 1));
+    for (int start = 0; start < nChildren; start += traits::NONLEAFSIZE + 1) {
+      PageId nonLeafPageNo;
+      Page* nonLeafPage;
+      this->bufMgr->allocPage(this->file, nonLeafPageNo, nonLeafPage);
+      nonLeafType* pageData = reinterpret_cast<nonLeafType*>(nonLeafPage);
+      int count = std::min(traits::NONLEAFSIZE + 1, nChildren - start);
+      pageData->level = nodeLevel;
+      pageData->pageNoArray[0] = level[start].second;
+      for (int j = 1; j < count; j++) {
+        traits::assign(pageData->keyArray[j-1], traits::fromSortKey(level[start+j].first));
+        pageData->pageNoArray[j] = level[start+j].second;
+      }
+      pageData->slotUse = count - 1;
+      this->bufMgr->unPinPage(this->file, nonLeafPageNo, true);
+      upperLevel.push_back(std::pair<sortType, PageId>(level[start].first, nonLeafPageNo));
+    }
+    level.swap(upperLevel);
+    nodeLevel++;
+  }
+
+  nonLeafType* rootData = reinterpret_cast<nonLeafType*>(rootPage);
+  rootData->level = nodeLevel;
+  rootData->pageNoArray[0] = level[0].second;
+  traits::assign(rootData->keyArray[0], 0);
+  for (int j = 1; j < (int)level.size(); j++) {
+    traits::assign(rootData->keyArray[j-1], traits::fromSortKey(level[j].first));
+    rootData->pageNoArray[j] = level[j].second;
+  }
+  rootData->slotUse = (int)level.size() - 1;
+  this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
+#ifdef DEBUG
+  if (this->attributeType != STRING) {
+    bool rc = this->isStructureValid<keyType,traits>();
+    assert(true == rc);
+  }
+#endif
+}
+
+/**
+ * @brief Moves the descent one interior level closer to the leaf holding keyValue.
+ * @details Factored out of getPageNoAndOffsetOfKeyInsert so the caller can
+ * unroll the descent for the common tree heights instead of running a loop.
+ */
+template<typename keyType, typename traits>
+inline void BTreeIndex::descendOne(BufMgr* const bm, File* const fp, keyType keyValue, typename traits::nonLeafType*& currPage, PageId& lastPage, std::pair<int,PageId>* pathOfTraversal, int& pathDepth) {
+  typedef typename traits::nonLeafType nonLeafType;
+  int i;
+  if (traits::less(keyValue,currPage->keyArray[0])) {
+    // Case smaller than all keys
+    i = 0;
+  } else {
+    /* invariant page[i] contains keys >= key[i-1]
+     * invariant page[i] contains keys < key [i]
+     * so the key belongs in the child after the last key less than or equal to it. */
+    i = traits::findFirstGreater(currPage->keyArray, currPage->slotUse, keyValue);
+  }
+#ifdef DEBUG
+  assert(pathDepth < MAXTREEHEIGHT);
+#endif
+  pathOfTraversal[pathDepth++] = std::pair<int,PageId>(i, lastPage);
+  // TODO karantalreja : if i == traits::NONLEAFSIZE then need to split page
+  bm->unPinPage(fp, lastPage, false);
+  Page* tempPage;
+  bm->readPage(fp, currPage->pageNoArray[i], tempPage);
+  lastPage = currPage->pageNoArray[i];
+  currPage = reinterpret_cast<nonLeafType*>(tempPage);
+}
+
+/**
+ * @brief Finds the leaf page and the slot where a scan for key should begin.
+ * @details Read-only counterpart of getPageNoAndOffsetOfKeyInsert: no descent
+ * path is recorded and nothing ever splits, so the scan setup stays free of
+ * the whole split machinery. Landing one past the last slot of a full leaf is
+ * fine; the caller follows the sibling pointer from there.
+ */
+template<typename keyType, typename traits>
+void BTreeIndex::findLeafForScan(const void* key, Page* rootPage, PageId& pageNo, int& startAt) {
+  typedef typename traits::leafType leafType;
+  typedef typename traits::nonLeafType nonLeafType;
+  BufMgr* const bm = this->bufMgr;
+  File* const fp = this->file;
+  const keyType keyValue = traits::getKeyValue(key);
   nonLeafType* rootData = reinterpret_cast<nonLeafType*>(rootPage);
   nonLeafType* currPage = rootData;
-  // <going to pade index , coming from page id>
-  std::vector<std::pair<int,PageId>> pathOfTraversal;
   PageId lastPage = this->rootPageNum;
   Page* tempPage;
-  while (depth < rootData->level) {
-    if (traits::less(keyValue,currPage->keyArray[0])) {
-      // Case smaller than all keys
-      i = 0;
-      pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-    } else {
-      // invariant page[i] contains keys >= key[i-1]
-      // invariant page[i] contains keys < key [i]
-      for (i = 0; i < traits::NONLEAFSIZE; i++) {
-        if (currPage->pageNoArray[i+1] == Page::INVALID_NUMBER) {
-          pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-          break;
-        }
-        /* 1st page contains keys greater than key[0] so if keyValue is greater than key[1]:
-         * the key must lie in page[2] or ahead. Since page[2] contains keys greater than key[1] */
-        if (traits::lessE(currPage->keyArray[i],keyValue)) {
-          // If the next page is not invalid, it might contain the key, so continue.
-#ifdef DEBUG
-          // keys all smaller than keyArray[i] should lie in this page so it should be valid
-          assert(currPage->pageNoArray[i] != Page::INVALID_NUMBER);
-          // keys all greater than equal to keyArray[i] should lie in page[i+1] or ahead.
-          assert(currPage->pageNoArray[i+1] != Page::INVALID_NUMBER);
-#endif
-            continue; // means if this was the last page in the node, we need to add to this page only otherwise continue
-        }
-        pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-        break;
-      }
-    }
-    if (i == traits::NONLEAFSIZE) {
-      pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-    }
-    // TODO karantalreja : if i == traits::NONLEAFSIZE then need to split page
-    this->bufMgr->unPinPage(this->file, lastPage, false);
-    this->bufMgr->readPage(this->file, currPage->pageNoArray[i], tempPage);
+  for (int depth = 1; depth < rootData->level; depth++) {
+    int i;
+    if (traits::less(keyValue,currPage->keyArray[0])) i = 0;
+    else i = traits::findFirstGreater(currPage->keyArray, currPage->slotUse, keyValue);
+    bm->unPinPage(fp, lastPage, false);
+    bm->readPage(fp, currPage->pageNoArray[i], tempPage);
     lastPage = currPage->pageNoArray[i];
     currPage = reinterpret_cast<nonLeafType*>(tempPage);
-    depth++;
   }
   pageNo = lastPage;
-  i = 0;
-  insertAt = traits::LEAFSIZE;
   leafType* dataPage = reinterpret_cast<leafType*>(currPage);
-  for (i = 0; i < traits::LEAFSIZE; i++) {
-    if (dataPage->ridArray[i].page_number == Page::INVALID_NUMBER) {
-      if (insertAt == traits::LEAFSIZE) insertAt = i;
-      break;
-    }
-    if (traits::great(keyValue,dataPage->keyArray[i])) continue;
-    if (insertAt == traits::LEAFSIZE) {
-      insertAt = i;
-      if (insert == false) break;
-    }
+  startAt = traits::findFirstGreaterEq(dataPage->keyArray, dataPage->slotUse, keyValue);
+  bm->unPinPage(fp, lastPage, false);
+}
+
+template<typename keyType, typename traits>
+void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage, PageId& pageNo, int& insertAt, int& endOfRecordsOffset, PageId& lastPageNo, Page*& leafPage)
+{
+  typedef typename traits::leafType leafType;
+  typedef typename traits::nonLeafType nonLeafType;
+  // Hoisted once so the compiler does not reload the members after every
+  // non-inlined buffer manager call.
+  BufMgr* const bm = this->bufMgr;
+  File* const fp = this->file;
+  int i = 0, depth = 1;
+  const keyType keyValue = traits::getKeyValue(key);
+  nonLeafType* rootData = reinterpret_cast<nonLeafType*>(rootPage);
+  nonLeafType* currPage = rootData;
+  // <going to pade index , coming from page id>
+  // Fixed-size descent record; keeps the hot insert path free of heap
+  // allocation since tree height is bounded by MAXTREEHEIGHT.
+  std::pair<int,PageId> pathOfTraversal[MAXTREEHEIGHT];
+  int pathDepth = 0;
+  PageId lastPage = this->rootPageNum;
+  // Unrolled descent for the common tree heights: the trip count is fixed by
+  // the root level, so spelling the steps out removes the loop control and
+  // lets each level's loads schedule independently.
+  switch (rootData->level) {
+  case 1:
+    break;
+  case 2:
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    break;
+  case 3:
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    break;
+  case 4:
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    break;
+  default:
+    for (depth = 1; depth < rootData->level; depth++)
+      this->descendOne<keyType,traits>(bm, fp, keyValue, currPage, lastPage, pathOfTraversal, pathDepth);
+    break;
   }
+  pageNo = lastPage;
+  leafType* dataPage = reinterpret_cast<leafType*>(currPage);
+  int nOcc = dataPage->slotUse;
+  insertAt = traits::findFirstGreaterEq(dataPage->keyArray, nOcc, keyValue);
+  i = nOcc;
   bool done = false;
   if (i == traits::LEAFSIZE) {
     // split data page
     Page* greaterKey;
     int medianIdx = traits::LEAFSIZE/2;
+    // Append-only shortcut: if the new key is greater than every key on the
+    // full leaf, split at the very end. The left leaf stays untouched, the
+    // new right leaf starts out empty and immediately receives the key, and
+    // the key itself becomes the separator. Sequential loads then move zero
+    // slots per split instead of half the page.
+    bool tailSplit = insertAt == traits::LEAFSIZE;
+    if (tailSplit) medianIdx = traits::LEAFSIZE;
     PageId GparentPageId;
     int Goffset;
     nonLeafType* GparentData;
     int k=0;
-    while (pathOfTraversal.size() >= 1) {
+    while (pathDepth >= 1) {
       PageId parentPageId;
       int offset;
       Page* parentPage;
       nonLeafType* parentData;
-      parentPageId = pathOfTraversal.back().second;
-      offset = pathOfTraversal.back().first;  // The page idx in parent pageArray in which the key wants to go.
-      pathOfTraversal.pop_back();
-      this->bufMgr->readPage(this->file, parentPageId, parentPage);
+      parentPageId = pathOfTraversal[pathDepth-1].second;
+      offset = pathOfTraversal[pathDepth-1].first;  // The page idx in parent pageArray in which the key wants to go.
+      pathDepth--;
+      bm->readPage(fp, parentPageId, parentPage);
       parentData = reinterpret_cast<nonLeafType*>(parentPage);
       if (done == false) {
         GparentPageId = parentPageId;
         Goffset = offset;
         GparentData = parentData;
       }
-      for (k = offset; k <= traits::NONLEAFSIZE; k++) {
-        if (parentData->pageNoArray[k] == Page::INVALID_NUMBER) break;
-      }
+      k = parentData->slotUse + 1;  // index of the first unused child slot
 
       // Split parent page
       if (k == traits::NONLEAFSIZE+1) {
         Page* greaterParentPage;
         int medianIdxParent = traits::NONLEAFSIZE/2;
-        nonLeafType newRootData;
+        nonLeafType* newRootData;
         Page* newRoot;
         int parentParentOffset = 0;
         PageId parentParentPageId;
-        if (pathOfTraversal.empty()) {
-          this->bufMgr->allocPage(this->file, this->rootPageNum, newRoot);
+        if (pathDepth == 0) {
+          bm->allocPage(fp, this->rootPageNum, newRoot);
           parentParentPageId = this->rootPageNum;
-          memset(&newRootData, 0, sizeof(nonLeafType));
-          newRootData.level = parentData->level+1;
-          newRootData.pageNoArray[0] = parentPageId;
+          // Edit the new root directly in the buffer-pool page; slotUse
+          // bounds all readers, so nothing else needs initializing.
+          newRootData = reinterpret_cast<nonLeafType*>(newRoot);
+          newRootData->level = parentData->level+1;
+          newRootData->pageNoArray[0] = parentPageId;
+          newRootData->slotUse = 0;
+          this->moveRootPin(parentPageId);
         } else {
-          parentParentPageId = pathOfTraversal.back().second;
-          this->bufMgr->readPage(this->file, parentParentPageId, newRoot);
-          newRootData = *reinterpret_cast<nonLeafType*>(newRoot);
-          parentParentOffset = pathOfTraversal.back().first;
+          parentParentPageId = pathOfTraversal[pathDepth-1].second;
+          bm->readPage(fp, parentParentPageId, newRoot);
+          newRootData = reinterpret_cast<nonLeafType*>(newRoot);
+          parentParentOffset = pathOfTraversal[pathDepth-1].first;
         }
-        for (k = parentParentOffset; k <= traits::NONLEAFSIZE; k++) {
-          if (newRootData.pageNoArray[k] == Page::INVALID_NUMBER) break;
-        }
-        for (; k > parentParentOffset; k--) {
-          if (k-1 >= 0) newRootData.pageNoArray[k] = newRootData.pageNoArray[k-1];
-          if (k-2 >= 0) traits::assign(newRootData.keyArray[k-1],newRootData.keyArray[k-2]);
+        k = newRootData->slotUse + 1;  // index of the first unused child slot
+        if (k > parentParentOffset) {
+          // Shift children and keys right by one slot in bulk; memmove
+          // handles the overlap and copies wide instead of slot by slot.
+          memmove(&newRootData->pageNoArray[parentParentOffset+1], &newRootData->pageNoArray[parentParentOffset], (k - parentParentOffset) * sizeof(PageId));
+          int keySrc = (parentParentOffset > 0) ? parentParentOffset - 1 : 0;
+          if (k-1 > keySrc) memmove(&newRootData->keyArray[keySrc+1], &newRootData->keyArray[keySrc], (k - 1 - keySrc) * sizeof(newRootData->keyArray[0]));
         }
 #ifdef DEBUG
-        assert(newRootData.pageNoArray[parentParentOffset+1] == Page::INVALID_NUMBER || newRootData.pageNoArray[parentParentOffset] == newRootData.pageNoArray[parentParentOffset+1]);
+        assert(newRootData->pageNoArray[parentParentOffset+1] == Page::INVALID_NUMBER || newRootData->pageNoArray[parentParentOffset] == newRootData->pageNoArray[parentParentOffset+1]);
 #endif
-        this->bufMgr->allocPage(this->file, newRootData.pageNoArray[parentParentOffset+1], greaterParentPage);
-        traits::assign(newRootData.keyArray[parentParentOffset], parentData->keyArray[medianIdxParent]);
+        bm->allocPage(fp, newRootData->pageNoArray[parentParentOffset+1], greaterParentPage);
+        traits::assign(newRootData->keyArray[parentParentOffset], parentData->keyArray[medianIdxParent]);
+        newRootData->slotUse++;
 
-        nonLeafType dataPageRight;
-        memset(&dataPageRight, 0, sizeof(nonLeafType));
-        dataPageRight.level = parentData->level;
+        // Build the right half directly in the buffer-pool page; slotUse bounds
+        // all readers, so only the slots moved over need to be written.
+        nonLeafType* dataPageRight = reinterpret_cast<nonLeafType*>(greaterParentPage);
+        dataPageRight->level = parentData->level;
         for (int i = medianIdxParent+1, j = 0; i < traits::NONLEAFSIZE; i++,j++) {
-          traits::assign(dataPageRight.keyArray[j], parentData->keyArray[i]);
-          dataPageRight.pageNoArray[j+1] = parentData->pageNoArray[i+1];
+          traits::assign(dataPageRight->keyArray[j], parentData->keyArray[i]);
+          dataPageRight->pageNoArray[j+1] = parentData->pageNoArray[i+1];
           traits::assign(parentData->keyArray[i], 0);
           parentData->pageNoArray[i+1] = Page::INVALID_NUMBER;
         }
 
-        dataPageRight.pageNoArray[0] = parentData->pageNoArray[medianIdxParent+1];
+        dataPageRight->pageNoArray[0] = parentData->pageNoArray[medianIdxParent+1];
         parentData->pageNoArray[medianIdxParent+1] = Page::INVALID_NUMBER;
         traits::assign(parentData->keyArray[medianIdxParent],0);
+        dataPageRight->slotUse = traits::NONLEAFSIZE - medianIdxParent - 1;
+        parentData->slotUse = medianIdxParent;
 
         if (done == false) {
-          if (traits::greatE(keyValue,newRootData.keyArray[parentParentOffset])) {
+          if (traits::greatE(keyValue,newRootData->keyArray[parentParentOffset])) {
             GparentData = reinterpret_cast<nonLeafType*>(greaterParentPage);
             Goffset = offset - medianIdxParent - 1;
             i = Goffset - 1;
-            GparentPageId = newRootData.pageNoArray[parentParentOffset+1];
+            GparentPageId = newRootData->pageNoArray[parentParentOffset+1];
             done = true;
           } else {
             GparentData = parentData;
@@ -901,22 +1460,19 @@ void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage,
           }
         }
 
-        memcpy(newRoot, &newRootData, sizeof(nonLeafType));
-        memcpy(greaterParentPage, &dataPageRight, sizeof(nonLeafType));
-
-        this->bufMgr->unPinPage(this->file, parentParentPageId, true);
-        if (traits::greatE(keyValue, newRootData.keyArray[parentParentOffset])) {
-          this->bufMgr->unPinPage(this->file, newRootData.pageNoArray[parentParentOffset], true);
-          if (newRootData.level >= 4)
-            this->bufMgr->unPinPage(this->file, newRootData.pageNoArray[parentParentOffset+1], true);
+        bm->unPinPage(fp, parentParentPageId, true);
+        if (traits::greatE(keyValue, newRootData->keyArray[parentParentOffset])) {
+          bm->unPinPage(fp, newRootData->pageNoArray[parentParentOffset], true);
+          if (newRootData->level >= 4)
+            bm->unPinPage(fp, newRootData->pageNoArray[parentParentOffset+1], true);
         } else {
-          this->bufMgr->unPinPage(this->file, newRootData.pageNoArray[parentParentOffset+1], true);
-          if (newRootData.level >= 4)
-            this->bufMgr->unPinPage(this->file, newRootData.pageNoArray[parentParentOffset], true);
+          bm->unPinPage(fp, newRootData->pageNoArray[parentParentOffset+1], true);
+          if (newRootData->level >= 4)
+            bm->unPinPage(fp, newRootData->pageNoArray[parentParentOffset], true);
         }
       } else {
         if (GparentPageId != parentPageId)
-          this->bufMgr->unPinPage(this->file, parentPageId, true);
+          bm->unPinPage(fp, parentPageId, true);
         break;
       }
     }
@@ -924,17 +1480,18 @@ void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage,
     int offset = Goffset;
     nonLeafType* parentData = GparentData;
 
-    for (k = offset; k <= traits::NONLEAFSIZE; k++) {
-      if (parentData->pageNoArray[k] == Page::INVALID_NUMBER) break;
-    }
+    k = parentData->slotUse + 1;  // index of the first unused child slot
 #ifdef DEBUG
     assert(k != traits::NONLEAFSIZE+1);
 #endif
-    for (; k > offset; k--) {
-      if (k-1 >= 0) parentData->pageNoArray[k] = parentData->pageNoArray[k-1];
-      if (k-2 >= 0) traits::assign(parentData->keyArray[k-1], parentData->keyArray[k-2]);
+    if (k > offset) {
+      memmove(&parentData->pageNoArray[offset+1], &parentData->pageNoArray[offset], (k - offset) * sizeof(PageId));
+      int keySrc = (offset > 0) ? offset - 1 : 0;
+      if (k-1 > keySrc) memmove(&parentData->keyArray[keySrc+1], &parentData->keyArray[keySrc], (k - 1 - keySrc) * sizeof(parentData->keyArray[0]));
     }
-    traits::assign(parentData->keyArray[offset],dataPage->keyArray[medianIdx]);
+    if (tailSplit) traits::assign(parentData->keyArray[offset],keyValue);
+    else traits::assign(parentData->keyArray[offset],dataPage->keyArray[medianIdx]);
+    parentData->slotUse++;
 #ifdef DEBUG
     assert(offset == 0 || traits::less(parentData->keyArray[offset-1],parentData->keyArray[offset]));
     if (offset+2 < traits::NONLEAFSIZE && parentData->pageNoArray[offset+2] != Page::INVALID_NUMBER)
@@ -944,16 +1501,22 @@ void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage,
     // if its the first empty slot its value should be Page::INVALID_NUMBER
     assert(parentData->pageNoArray[offset+1] == Page::INVALID_NUMBER || parentData->pageNoArray[offset] == parentData->pageNoArray[offset+1]);
 #endif
-    this->bufMgr->allocPage(this->file, parentData->pageNoArray[offset+1], greaterKey);
-    leafType dataPageRight;
-    memset(&dataPageRight, 0, sizeof(leafType));
-    dataPageRight.rightSibPageNo = dataPage->rightSibPageNo;
+    bm->allocPage(fp, parentData->pageNoArray[offset+1], greaterKey);
+    // Build the right half directly in the buffer-pool page; slotUse bounds all
+    // readers, so only the slots moved over need to be written.
+    leafType* dataPageRight = reinterpret_cast<leafType*>(greaterKey);
+    dataPageRight->rightSibPageNo = dataPage->rightSibPageNo;
     dataPage->rightSibPageNo = parentData->pageNoArray[offset+1];
 #ifdef DEBUG
     assert(insertAt == 0 || traits::less(dataPage->keyArray[insertAt-1],keyValue));
     assert(insertAt == traits::LEAFSIZE || traits::great(dataPage->keyArray[insertAt],keyValue));
 #endif
-    if (traits::great(keyValue,dataPage->keyArray[medianIdx])) {
+    if (tailSplit) {
+      insertAt = 0;
+      lastPageNo = pageNo;
+      pageNo = parentData->pageNoArray[offset+1];
+      endOfRecordsOffset = 0;
+    } else if (traits::great(keyValue,dataPage->keyArray[medianIdx])) {
       insertAt -= medianIdx;
       lastPageNo = pageNo;
       pageNo = parentData->pageNoArray[offset+1];
@@ -964,27 +1527,39 @@ void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage,
       endOfRecordsOffset = medianIdx;
     }
     for (int i = medianIdx, j = 0; i < traits::LEAFSIZE; i++,j++) {
-      traits::assign(dataPageRight.keyArray[j],dataPage->keyArray[i]);
-      dataPageRight.ridArray[j] = dataPage->ridArray[i];
+      traits::assign(dataPageRight->keyArray[j],dataPage->keyArray[i]);
+      dataPageRight->ridArray[j] = dataPage->ridArray[i];
       traits::assign(dataPage->keyArray[i],0);
       dataPage->ridArray[i].page_number = Page::INVALID_NUMBER;
       dataPage->ridArray[i].slot_number = 0;
     }
-    memcpy(greaterKey, &dataPageRight, sizeof(leafType));
+    dataPageRight->slotUse = traits::LEAFSIZE - medianIdx;
+    dataPage->slotUse = medianIdx;
 #ifdef DEBUG
-    if (traits::great(keyValue,dataPageRight.keyArray[0])) {
-      assert(insertAt == 0 || traits::less(dataPageRight.keyArray[insertAt-1], keyValue));
-      assert(insertAt == traits::LEAFSIZE || insertAt == endOfRecordsOffset || traits::great(dataPageRight.keyArray[insertAt],keyValue));
+    if (tailSplit) {
+      assert(insertAt == 0 && endOfRecordsOffset == 0);
+    } else if (traits::great(keyValue,dataPageRight->keyArray[0])) {
+      assert(insertAt == 0 || traits::less(dataPageRight->keyArray[insertAt-1], keyValue));
+      assert(insertAt == traits::LEAFSIZE || insertAt == endOfRecordsOffset || traits::great(dataPageRight->keyArray[insertAt],keyValue));
     } else {
       assert(insertAt == 0 || traits::less(dataPage->keyArray[insertAt-1], keyValue));
       assert(insertAt == traits::LEAFSIZE || insertAt == endOfRecordsOffset || traits::great(dataPage->keyArray[insertAt],keyValue));
     }
 #endif
-    this->bufMgr->unPinPage(this->file, lastPage, true);
-    this->bufMgr->unPinPage(this->file, parentPageId, true);
-    this->bufMgr->unPinPage(this->file, parentData->pageNoArray[offset+1], true);
+    // Hand the destination half of the split back still pinned; the caller
+    // places the key and releases the pin, instead of unpinning here only to
+    // re-pin the same page immediately.
+    if (pageNo == lastPage) {
+      leafPage = reinterpret_cast<Page*>(dataPage);
+      bm->unPinPage(fp, parentData->pageNoArray[offset+1], true);
+    } else {
+      leafPage = greaterKey;
+      bm->unPinPage(fp, lastPage, true);
+    }
+    bm->unPinPage(fp, parentPageId, true);
   } else {
-    this->bufMgr->unPinPage(this->file, lastPage, false);
+    // No split: the leaf stays pinned and goes back to the caller.
+    leafPage = reinterpret_cast<Page*>(dataPage);
     endOfRecordsOffset = i;
     lastPageNo = pageNo;
   }
@@ -997,84 +1572,188 @@ void BTreeIndex::getPageNoAndOffsetOfKeyInsert(const void* key, Page* rootPage,
 }
 
 
+/**
+ * @brief Reports scan completion. Kept out of line and cold so the throw and
+ * its unwind code stay away from the scanNext hot path.
+ */
+__attribute__((cold, noinline, noreturn))
+inline void throwScanComplete() {
+  throw IndexScanCompletedException();
+}
+
+/**
+ * @brief Unpins the leaf the scan finished on and reports completion.
+ * Out-of-line cold path like throwScanComplete.
+ */
+__attribute__((cold, noinline, noreturn))
+inline void throwScanDone(BufMgr* bm, File* fp, PageId pageNo) {
+  bm->unPinPage(fp, pageNo, false);
+  throw IndexScanCompletedException();
+}
+
+template <typename keyType, class traits>
+void BTreeIndex::computeScanStop() {
+  typedef typename traits::leafType leafType;
+  leafType* dataPage = reinterpret_cast<leafType*>(this->currentPageData);
+  // One vectorized upper-bound search per page visit: past the bound always
+  // ends the scan, on the bound only for an exclusive upper operator. Every
+  // per-tuple bound check afterwards is an integer compare with the result.
+  const int boundIdx = (this->highOp == LT)
+      ? traits::findFirstGreaterEq(dataPage->keyArray, this->currentPageOcc, traits::getUpperBound(this))
+      : traits::findFirstGreater(dataPage->keyArray, this->currentPageOcc, traits::getUpperBound(this));
+  this->currentPageStop = boundIdx;
+  this->currentStopAtBound = boundIdx < this->currentPageOcc;
+}
+
 template <typename keyType, class traits>
 const void BTreeIndex::scanNextTemplate(RecordId& outRid) {
-  if (this->currentPageData == NULL) throw IndexScanCompletedException();
+  if (__builtin_expect(this->currentPageData == NULL, 0)) throwScanComplete();
   typedef typename traits::leafType leafType;
+  BufMgr* const bm = this->bufMgr;
+  File* const fp = this->file;
   leafType* dataPage = reinterpret_cast<leafType*>(this->currentPageData);
-  if (this->highOp == LT && traits::greatE(dataPage->keyArray[this->nextEntry],traits::getUpperBound(this))) {
-    this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-    throw IndexScanCompletedException();
-  }
-  if (this->highOp == LTE && traits::great(dataPage->keyArray[this->nextEntry],traits::getUpperBound(this))) {
-    this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-    throw IndexScanCompletedException();
+  // The page turn is fused with the new page's range check: entering a page
+  // recomputes the stop index once, so the per-tuple fast path below is a
+  // single compare against it with no key loads at all.
+  while (__builtin_expect(this->nextEntry >= this->currentPageStop, 0)) {
+    if (this->currentStopAtBound) {
+      // Mark the pin as released before the cold helper drops it so endScan
+      // does not unpin the same leaf a second time.
+      this->currentPageData = NULL;
+      throwScanDone(bm, fp, this->currentPageNum);
+    }
+    const PageId rightSib = dataPage->rightSibPageNo;
+    bm->unPinPage(fp, this->currentPageNum, false);
+    this->nextEntry = 0;
+    this->currentPageNum = rightSib;
+    if (rightSib == Page::INVALID_NUMBER) {
+      this->currentPageData = NULL;
+      throwScanComplete();
+    }
+    bm->readPage(fp, this->currentPageNum, this->currentPageData);
+    this->currentPageOcc = this->getOccupancy<keyType, traits>(this->currentPageData, true);
+    this->computeScanStop<keyType, traits>();
+    dataPage = reinterpret_cast<leafType*>(this->currentPageData);
   }
   outRid = dataPage->ridArray[this->nextEntry];
   #ifdef DEBUG
   assert(outRid.page_number != Page::INVALID_NUMBER);
   assert(outRid.slot_number != 0);
   #endif
-  if (this->nextEntry + 1 == traits::LEAFSIZE || dataPage->ridArray[this->nextEntry+1].page_number == Page::INVALID_NUMBER) {
-    this->nextEntry = 0;
-    this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-    this->currentPageNum = dataPage->rightSibPageNo;
-    if (this->currentPageNum == Page::INVALID_NUMBER) {
+  // Warm the right sibling shortly before the end of the leaf; the page is
+  // unpinned immediately, the read is only for pool residency so the page
+  // turn above does not stall on the fetch.
+  if (this->nextEntry + SCANPREFETCHDIST == this->currentPageOcc
+      && dataPage->rightSibPageNo != Page::INVALID_NUMBER) {
+    Page* prefetchPage;
+    bm->readPage(fp, dataPage->rightSibPageNo, prefetchPage);
+    bm->unPinPage(fp, dataPage->rightSibPageNo, false);
+  }
+  this->nextEntry++;
+}
+
+template <typename keyType, class traits>
+const int BTreeIndex::scanNextBatchTemplate(RecordId* outRids, const int maxN) {
+  if (__builtin_expect(this->currentPageData == NULL, 0)) throwScanComplete();
+  typedef typename traits::leafType leafType;
+  BufMgr* const bm = this->bufMgr;
+  File* const fp = this->file;
+  int filled = 0;
+  while (filled < maxN) {
+    leafType* dataPage = reinterpret_cast<leafType*>(this->currentPageData);
+    // The stop index caps the run of qualifying entries: one upper-bound
+    // search per page visit instead of one compare per record. Everything
+    // before it copies out in a single memcpy.
+    int runEnd = this->currentPageStop;
+    if (runEnd - this->nextEntry > maxN - filled) runEnd = this->nextEntry + (maxN - filled);
+    if (runEnd > this->nextEntry) {
+      memcpy(outRids + filled, &dataPage->ridArray[this->nextEntry],
+             (runEnd - this->nextEntry) * sizeof(RecordId));
+      filled += runEnd - this->nextEntry;
+      this->nextEntry = runEnd;
+    }
+    if (this->currentStopAtBound) {
+      // The upper bound falls inside this leaf; once the run has been
+      // handed out the scan is over.
+      if (filled > 0) return filled;
       this->currentPageData = NULL;
-    } else this->bufMgr->readPage(this->file, this->currentPageNum, this->currentPageData);
-  } else this->nextEntry++;
+      throwScanDone(bm, fp, this->currentPageNum);
+    }
+    if (this->nextEntry >= this->currentPageOcc) {
+      const PageId rightSib = dataPage->rightSibPageNo;
+      bm->unPinPage(fp, this->currentPageNum, false);
+      this->nextEntry = 0;
+      this->currentPageNum = rightSib;
+      if (rightSib == Page::INVALID_NUMBER) {
+        this->currentPageData = NULL;
+        if (filled > 0) return filled;
+        throwScanComplete();
+      }
+      bm->readPage(fp, this->currentPageNum, this->currentPageData);
+      this->currentPageOcc = this->getOccupancy<keyType, traits>(this->currentPageData, true);
+      this->computeScanStop<keyType, traits>();
+    }
+  }
+  return filled;
 }
 
 template <typename keyType, class traits>
 const void BTreeIndex::startScanTemplate(const void* lowVal, const void* highVal) {
   traits::setScanBounds(this, lowVal, highVal);
   typedef typename traits::leafType leafType;
+  BufMgr* const bm = this->bufMgr;
+  File* const fp = this->file;
   Page* rootPage;
-  this->bufMgr->readPage(this->file, this->rootPageNum, rootPage);
-  int insertAt, endOfRecordsOffset;
-  PageId dataPageNum, dataPageNumPrev;
-  this->getPageNoAndOffsetOfKeyInsert<keyType>(lowVal, rootPage, dataPageNum, insertAt, endOfRecordsOffset, dataPageNumPrev, false);
-  if (dataPageNumPrev == dataPageNum) { //TODO karantalreja : Handle the non equal case
-    this->currentPageNum = dataPageNum;
-    this->bufMgr->readPage(this->file, this->currentPageNum, this->currentPageData);
-    this->nextEntry = insertAt;
-    leafType* dataPage = reinterpret_cast<leafType*>(this->currentPageData);
-    if (dataPage->ridArray[this->nextEntry].page_number == Page::INVALID_NUMBER) {
-      if (Page::INVALID_NUMBER != dataPage->rightSibPageNo) {
-        this->nextEntry = 0;
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-        this->currentPageNum = dataPage->rightSibPageNo;
-        if (this->currentPageNum == Page::INVALID_NUMBER) {
-          this->currentPageData = NULL;
-          throw NoSuchKeyFoundException();
-        } else this->bufMgr->readPage(this->file, this->currentPageNum, this->currentPageData);
-      } else {
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+  bm->readPage(fp, this->rootPageNum, rootPage);
+  int insertAt;
+  PageId dataPageNum;
+  this->findLeafForScan<keyType, traits>(lowVal, rootPage, dataPageNum, insertAt);
+  this->currentPageNum = dataPageNum;
+  bm->readPage(fp, this->currentPageNum, this->currentPageData);
+  this->currentPageOcc = this->getOccupancy<keyType, traits>(this->currentPageData, true);
+  this->computeScanStop<keyType, traits>();
+  this->nextEntry = insertAt;
+  leafType* dataPage = reinterpret_cast<leafType*>(this->currentPageData);
+  if (this->nextEntry >= this->currentPageOcc) {
+    if (Page::INVALID_NUMBER != dataPage->rightSibPageNo) {
+      this->nextEntry = 0;
+      bm->unPinPage(fp, this->currentPageNum, false);
+      this->currentPageNum = dataPage->rightSibPageNo;
+      if (this->currentPageNum == Page::INVALID_NUMBER) {
+        this->currentPageData = NULL;
         throw NoSuchKeyFoundException();
+      } else {
+        bm->readPage(fp, this->currentPageNum, this->currentPageData);
+        this->currentPageOcc = this->getOccupancy<keyType, traits>(this->currentPageData, true);
+        this->computeScanStop<keyType, traits>();
       }
-    }
-    if (this->lowOp == GT) {
-      if (traits::equal(dataPage->keyArray[this->nextEntry],traits::getLowBound(this))) {
-        if (this->nextEntry + 1 == traits::LEAFSIZE || dataPage->ridArray[this->nextEntry+1].page_number == Page::INVALID_NUMBER) {
-          this->nextEntry = 0;
-          this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          this->currentPageNum = dataPage->rightSibPageNo;
-          this->bufMgr->readPage(this->file, this->currentPageNum, this->currentPageData);
-        } else this->nextEntry++;
-      }
-    }
-    if (traits::great(dataPage->keyArray[this->nextEntry],traits::getUpperBound(this))) {
-      this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+    } else {
+      bm->unPinPage(fp, this->currentPageNum, false);
+      this->currentPageData = NULL;
       throw NoSuchKeyFoundException();
     }
-    else if (this->highOp == LT && traits::equal(dataPage->keyArray[this->nextEntry], traits::getUpperBound(this))){
-      this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-      throw NoSuchKeyFoundException();
+  }
+  if (this->lowOp == GT) {
+    if (traits::equal(dataPage->keyArray[this->nextEntry],traits::getLowBound(this))) {
+      if (this->nextEntry + 1 >= this->currentPageOcc) {
+        this->nextEntry = 0;
+        bm->unPinPage(fp, this->currentPageNum, false);
+        this->currentPageNum = dataPage->rightSibPageNo;
+        bm->readPage(fp, this->currentPageNum, this->currentPageData);
+        this->currentPageOcc = this->getOccupancy<keyType, traits>(this->currentPageData, true);
+        this->computeScanStop<keyType, traits>();
+      } else this->nextEntry++;
     }
-  } else {
-    #ifdef DEBUG
-    //assert(0);
-    #endif
+  }
+  if (traits::great(dataPage->keyArray[this->nextEntry],traits::getUpperBound(this))) {
+    bm->unPinPage(fp, this->currentPageNum, false);
+    this->currentPageData = NULL;
+    throw NoSuchKeyFoundException();
+  }
+  else if (this->highOp == LT && traits::equal(dataPage->keyArray[this->nextEntry], traits::getUpperBound(this))){
+    bm->unPinPage(fp, this->currentPageNum, false);
+    this->currentPageData = NULL;
+    throw NoSuchKeyFoundException();
   }
 }
 
@@ -1084,50 +1763,55 @@ const void BTreeIndex::insertKeyTemplate(const void* key, const RecordId rid) {
   typedef typename traits::nonLeafType nonLeafType;
   typedef typename traits::leafType leafType;
   Page* rootPage;
-  keyType keyValue = traits::getKeyValue(key);
+  const keyType keyValue = traits::getKeyValue(key);
   this->bufMgr->readPage(this->file, this->rootPageNum, rootPage);
   nonLeafType* rootData = reinterpret_cast<nonLeafType*>(rootPage);
-  if (rootData->pageNoArray[0] == Page::INVALID_NUMBER) {
+  // The empty-tree test dereferences the root only until the first insert;
+  // afterwards the cached flag settles the branch without touching rootData.
+  if (__builtin_expect(this->rootHasChildren == false, 0)
+      && rootData->pageNoArray[0] == Page::INVALID_NUMBER) {
     Page* lessKey, *greaterKey;
     this->bufMgr->allocPage(this->file, rootData->pageNoArray[0], lessKey);
     this->bufMgr->allocPage(this->file, rootData->pageNoArray[1], greaterKey);
 
-    leafType dataPageLeft, dataPageRight;
-    memset(&dataPageLeft, 0, sizeof(leafType));
-    memset(&dataPageRight, 0, sizeof(leafType));
-
-    dataPageLeft.rightSibPageNo = rootData->pageNoArray[1];
-
-    memcpy(lessKey, &dataPageLeft, sizeof(leafType));
+    // Build both leaves directly on the pinned frames; slotUse bounds all
+    // readers, so only the sibling links and the one occupied slot need
+    // stores instead of a zeroed stack image copied over per page.
+    leafType* dataPageLeft = reinterpret_cast<leafType*>(lessKey);
+    dataPageLeft->rightSibPageNo = rootData->pageNoArray[1];
+    dataPageLeft->slotUse = 0;
     this->bufMgr->unPinPage(this->file, rootData->pageNoArray[0], true);
 
-    traits::assign(dataPageRight.keyArray[0],keyValue);
-    dataPageRight.ridArray[0] = rid;
-    memcpy(greaterKey, &dataPageRight, sizeof(leafType));
+    leafType* dataPageRight = reinterpret_cast<leafType*>(greaterKey);
+    dataPageRight->rightSibPageNo = Page::INVALID_NUMBER;
+    traits::assign(dataPageRight->keyArray[0],keyValue);
+    dataPageRight->ridArray[0] = rid;
+    dataPageRight->slotUse = 1;
     this->bufMgr->unPinPage(this->file, rootData->pageNoArray[1], true);
 
     rootData->level = 2;
     traits::assign(rootData->keyArray[0],keyValue);
+    rootData->slotUse = 1;
+    this->rootHasChildren = true;
     this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
   } else {
+    this->rootHasChildren = true;
     PageId dataPageNum;
     PageId dataPageNumPrev;
     Page* tempPage;
     int insertAt = -1, endOfRecordsOffset;
-    getPageNoAndOffsetOfKeyInsert<keyType>(key, rootPage, dataPageNum, insertAt, endOfRecordsOffset, dataPageNumPrev);
-    this->bufMgr->readPage(this->file, dataPageNum, tempPage);
+    getPageNoAndOffsetOfKeyInsert<keyType>(key, rootPage, dataPageNum, insertAt, endOfRecordsOffset, dataPageNumPrev, tempPage);
     leafType* dataPage = reinterpret_cast<leafType*>(tempPage);
 
-    for (int j = endOfRecordsOffset; j > insertAt; j--) {
-      dataPage->ridArray[j] = dataPage->ridArray[j-1];
-      traits::assign(dataPage->keyArray[j],dataPage->keyArray[j-1]);
+    if (endOfRecordsOffset > insertAt) {
+      memmove(&dataPage->ridArray[insertAt+1], &dataPage->ridArray[insertAt], (endOfRecordsOffset - insertAt) * sizeof(RecordId));
+      memmove(&dataPage->keyArray[insertAt+1], &dataPage->keyArray[insertAt], (endOfRecordsOffset - insertAt) * sizeof(dataPage->keyArray[0]));
     }
     dataPage->ridArray[insertAt] = rid;
     traits::assign(dataPage->keyArray[insertAt],keyValue);
+    dataPage->slotUse = endOfRecordsOffset + 1;
     this->bufMgr->unPinPage(this->file, dataPageNum, true);
-#ifdef DEBUG
-    std::cout << "DBG: Key " << keyValue << " inserted on page " << dataPageNum << " at offset " << insertAt << ":" << endOfRecordsOffset << std::endl;
-#endif
+    BTREE_DBG("DBG: Key " << keyValue << " inserted on page " << dataPageNum << " at offset " << insertAt << ":" << endOfRecordsOffset);
 #ifdef DEBUG
   if (this->attributeType != STRING) {
     bool rc = this->isStructureValid<keyType,traits>();
@@ -1312,26 +1996,13 @@ int BTreeIndex::getOccupancy(Page* currPage, bool dataPage) {
   typedef typename traits::leafType leafType;
   int retval;
   if (dataPage == true) {
-    leafType* dataPage = reinterpret_cast<leafType*>(currPage);
-    retval = traits::LEAFSIZE;
-    for (int i = 0; i < traits::LEAFSIZE; i++) {
-      if (dataPage->ridArray[i].page_number == Page::INVALID_NUMBER) {
-        retval = i;
-        break;
-      }
-    }
+    retval = reinterpret_cast<leafType*>(currPage)->slotUse;
 #ifdef DEBUG
     assert(retval <= traits::LEAFSIZE);
 #endif
   } else {
-    nonLeafType* nonData = reinterpret_cast<nonLeafType*>(currPage);
-    retval = traits::NONLEAFSIZE+1;
-    for (int i = 0; i < traits::NONLEAFSIZE+1; i++) {
-      if (nonData->pageNoArray[i] == Page::INVALID_NUMBER) {
-        retval = i;
-        break;
-      }
-    }
+    // A non-leaf node always has one more child in use than keys.
+    retval = reinterpret_cast<nonLeafType*>(currPage)->slotUse + 1;
 #ifdef DEBUG
     assert(retval <= traits::NONLEAFSIZE+1);
 #endif
@@ -1355,6 +2026,7 @@ void BTreeIndex::deleteEntryInLeaf(Page* leafPage, int startLoc, int endLoc) {
   dataPage->ridArray[endLoc-1].page_number = Page::INVALID_NUMBER;
   dataPage->ridArray[endLoc-1].slot_number = Page::INVALID_SLOT;
   traits::assign(dataPage->keyArray[endLoc-1], 0);
+  dataPage->slotUse = endLoc - 1;
 }
 
 template<typename keyType, typename traits>
@@ -1384,6 +2056,7 @@ void BTreeIndex::deleteEntryInNonLeaf(Page* nonLeafPage, int startLoc, int endLo
 #endif
   traits::assign(parentPageData->keyArray[parentOccupancy-2], 0);
   parentPageData->pageNoArray[parentOccupancy-1] = Page::INVALID_NUMBER;
+  parentPageData->slotUse = parentOccupancy - 2;
 }
 
 template<typename keyType, typename traits>
@@ -1418,6 +2091,7 @@ void BTreeIndex::shiftRightPage (Page* leftSib, Page* page, int startLoc, int en
     traits::assign(leftPageData->keyArray[leftOccupancy-1], 0);
     leftPageData->ridArray[leftOccupancy-1].page_number = Page::INVALID_NUMBER;
     leftPageData->ridArray[leftOccupancy-1].slot_number = Page::INVALID_SLOT;
+    leftPageData->slotUse = leftOccupancy - 1;
   } else {
 #ifdef DEBUG
   assert(endLoc < traits::NONLEAFSIZE+1);
@@ -1442,6 +2116,8 @@ void BTreeIndex::shiftRightPage (Page* leftSib, Page* page, int startLoc, int en
 #endif
       dataPage->pageNoArray[0] = leftPageData->pageNoArray[leftOccupancy-1];
       leftPageData->pageNoArray[leftOccupancy-1] = Page::INVALID_NUMBER;
+      // The left sibling's last key moves up through the parent in the caller.
+      leftPageData->slotUse = leftOccupancy - 2;
     }
   }
 }
@@ -1477,6 +2153,7 @@ void BTreeIndex::shiftLeftPage (Page* rightSib, Page* page, int startLoc, int en
     traits::assign(rightPageData->keyArray[rightOccupancy-1], 0);
     rightPageData->ridArray[rightOccupancy-1].page_number = Page::INVALID_NUMBER;
     rightPageData->ridArray[rightOccupancy-1].slot_number = Page::INVALID_SLOT;
+    rightPageData->slotUse = rightOccupancy - 1;
   } else {
 #ifdef DEBUG
   assert(endLoc < traits::NONLEAFSIZE+1);
@@ -1487,8 +2164,10 @@ void BTreeIndex::shiftLeftPage (Page* rightSib, Page* page, int startLoc, int en
     nonLeafType* rightPageData = reinterpret_cast<nonLeafType*>(rightSib);
     nonLeafType* dataPage = reinterpret_cast<nonLeafType*>(page);
     this->deleteEntryInNonLeaf<keyType, traits>(reinterpret_cast<Page*>(dataPage), startLoc, endLoc);
-    
+
     dataPage->pageNoArray[endLoc-1] = rightPageData->pageNoArray[0];
+    // The separator key filled in by the caller brings the count back to endLoc-1.
+    dataPage->slotUse = endLoc - 1;
     int i = 0;
     for (i = 0; i < rightOccupancy-2; i++) {
       traits::assign(rightPageData->keyArray[i], rightPageData->keyArray[i+1]);
@@ -1502,6 +2181,7 @@ void BTreeIndex::shiftLeftPage (Page* rightSib, Page* page, int startLoc, int en
 #endif
     traits::assign(rightPageData->keyArray[rightOccupancy-2], 0);
     rightPageData->pageNoArray[rightOccupancy-1] = Page::INVALID_NUMBER;
+    rightPageData->slotUse = rightOccupancy - 2;
   }
 }
 template<typename keyType, typename traits>
@@ -1530,6 +2210,23 @@ bool BTreeIndex::isStructureValid() {
   nonLeafType* currData; 
   this->bufMgr->readPage(this->file, this->rootPageNum, page);
   currData = reinterpret_cast<nonLeafType*>(page);
+  // A root with no separator key (empty tree, or a bulk-loaded relation that
+  // fits in a single leaf) has nothing to propagate as a bound; the traversal
+  // below assumes at least two children, so validate the lone leaf directly.
+  if (currData->slotUse == 0) {
+    PageId childPageNo = currData->pageNoArray[0];
+    this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
+    if (childPageNo == Page::INVALID_NUMBER) return true;
+    this->bufMgr->readPage(this->file, childPageNo, page);
+    leafType* data = reinterpret_cast<leafType*>(page);
+    for (int i = 1; i < data->slotUse; i++) {
+#ifdef DEBUG
+      assert(traits::greatE(data->keyArray[i],data->keyArray[i-1]));
+#endif
+    }
+    this->bufMgr->unPinPage(this->file, childPageNo, true);
+    return true;
+  }
   // for max = true
   std::pair<typename std::pair<PageId,keyType>, bool> minOrMaxConstraint;
   minOrMaxConstraint.first.first = this->rootPageNum;
@@ -1598,9 +2295,8 @@ bool BTreeIndex::isStructureValid() {
   while (!queue[depth%2].empty()) {
     this->bufMgr->readPage(this->file, queue[depth%2].back().first.first, page);
     leafType* data = reinterpret_cast<leafType*>(page);
-    for (int i = 1; i < traits::LEAFSIZE; i++) {
-      if (data->ridArray[i].page_number == Page::INVALID_NUMBER) break;
-#ifdef DEBUG 
+    for (int i = 1; i < data->slotUse; i++) {
+#ifdef DEBUG
       assert(traits::greatE(data->keyArray[i],data->keyArray[i-1]));
 #endif
       minOrMaxConstraint = queue[depth%2].back();
@@ -1624,7 +2320,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
   typedef typename traits::nonLeafType nonLeafType;
   typedef typename traits::leafType leafType;
   Page* rootPage;
-  keyType keyValue = traits::getKeyValue(key);
+  const keyType keyValue = traits::getKeyValue(key);
 #ifdef DEBUG
     std::cout << "DBG: Key " << keyValue << " deleted through ";
 #endif
@@ -1640,34 +2336,13 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
     if (traits::less(keyValue,currPage->keyArray[0])) {
       // Case smaller than all keys
       i = 0;
-      pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
     } else {
-      // invariant page[i] contains keys >= key[i-1]
-      // invariant page[i] contains keys < key [i]
-      for (i = 0; i < traits::NONLEAFSIZE; i++) {
-        if (currPage->pageNoArray[i+1] == Page::INVALID_NUMBER) {
-          pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-          break;
-        }
-        /* 1st page contains keys greater than key[0] so if keyValue is greater than key[1]:
-         * the key must lie in page[2] or ahead. Since page[2] contains keys greater than key[1] */
-        if (traits::lessE(currPage->keyArray[i],keyValue)) {
-          // If the next page is not invalid, it might contain the key, so continue.
-#ifdef DEBUG
-          // keys all smaller than keyArray[i] should lie in this page so it should be valid
-          assert(currPage->pageNoArray[i] != Page::INVALID_NUMBER);
-          // keys all greater than equal to keyArray[i] should lie in page[i+1] or ahead.
-          assert(currPage->pageNoArray[i+1] != Page::INVALID_NUMBER);
-#endif
-          continue; // means if this was the last page in the node, we need to add to this page only otherwise continue
-        }
-        pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
-        break;
-      }
-    }
-    if (i == traits::NONLEAFSIZE) {
-      pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
+      /* invariant page[i] contains keys >= key[i-1]
+       * invariant page[i] contains keys < key [i]
+       * so the key belongs in the child after the last key less than or equal to it. */
+      i = traits::findFirstGreater(currPage->keyArray, currPage->slotUse, keyValue);
     }
+    pathOfTraversal.push_back(std::pair<int,PageId>(i, lastPage));
     this->bufMgr->unPinPage(this->file, lastPage, false);
     this->bufMgr->readPage(this->file, currPage->pageNoArray[i], tempPage);
     lastPage = currPage->pageNoArray[i];
@@ -1675,19 +2350,10 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
     depth++;
   }
   PageId dataPageId = lastPage;
-  i = 0;
-  int startLoc = traits::LEAFSIZE, endLoc;
+  int startLoc, endLoc;
   leafType* dataPage = reinterpret_cast<leafType*>(currPage);
-  for (i = 0; i < traits::LEAFSIZE; i++) {
-    if (dataPage->ridArray[i].page_number == Page::INVALID_NUMBER) {
-      if (startLoc == traits::LEAFSIZE) startLoc = i;
-      break;
-    }
-    if (traits::great(keyValue,dataPage->keyArray[i])) continue;
-    if (startLoc == traits::LEAFSIZE) {
-      startLoc = i;
-    }
-  }
+  i = dataPage->slotUse;
+  startLoc = traits::findFirstGreaterEq(dataPage->keyArray, i, keyValue);
 #ifdef DEBUG
   assert(pathOfTraversal.size());
   assert(startLoc < traits::LEAFSIZE);
@@ -1811,6 +2477,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
             traits::assign(leftPageData->keyArray[i],dataPage->keyArray[j]);
             leftPageData->ridArray[i] = dataPage->ridArray[j];
           }
+          leftPageData->slotUse = leftOccupancy + endLoc - 1;
           this->bufMgr->unPinPage(this->file, dataPageId, true);
           bool rotated = false;
           while (pathOfTraversal.size() >= 1) {
@@ -1853,6 +2520,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
 #endif
                 traits::assign(parentPageData->keyArray[0], keyValue);
                 this->rootPageNum = parentPageData->pageNoArray[0];
+                this->moveRootPin(parentPageId);
               } else {
 #ifdef DEBUG
                 assert(0);
@@ -1993,6 +2661,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   traits::assign(leftPageData->keyArray[i],parentPageData->keyArray[j-1]);
                   leftPageData->pageNoArray[i] = parentPageData->pageNoArray[j-1];
                 }
+                leftPageData->slotUse = pLeftOccupancy + parentOccupancy - 2;
                 pathOfTraversal.pop_back();
                 if (!pathOfTraversal.empty()) {
                   PageId parentParentPageOffset = pathOfTraversal.back().first;
@@ -2021,6 +2690,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   traits::assign(parentPageData->keyArray[i],rightPageData->keyArray[j]);
                   parentPageData->pageNoArray[i] = rightPageData->pageNoArray[j];
                 }
+                parentPageData->slotUse = parentOccupancy + pRightOccupancy - 1;
                 pathOfTraversal.pop_back();
                 if (!pathOfTraversal.empty()) {
                   PageId parentParentPageOffset = pathOfTraversal.back().first;
@@ -2075,7 +2745,9 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                 std::cout << "Non-leaf page made root." << std::endl;
 #endif
                 this->deleteEntryInNonLeaf<keyType, traits>(parentPage, parentPageOffset, parentOccupancy);
+                const PageId oldRootPageNo = this->rootPageNum;
                 this->rootPageNum = parentPageId;
+                this->moveRootPin(oldRootPageNo);
                 if (leftOccupancy != -1) this->bufMgr->unPinPage(this->file, leftSibling, true);
                 if (rightOccupancy != -1) this->bufMgr->unPinPage(this->file, rightSibling, true);
                 this->bufMgr->unPinPage(this->file, parentPageId, true);
@@ -2100,6 +2772,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
             traits::assign(dataPage->keyArray[i],rightPageData->keyArray[j]);
             dataPage->ridArray[i] = rightPageData->ridArray[j];
           }
+          dataPage->slotUse = endLoc + rightOccupancy;
           this->bufMgr->unPinPage(this->file, dataPageId, true);
           bool rotated = false;
           while (pathOfTraversal.size() >= 1) {
@@ -2115,6 +2788,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   traits::assign(parentPageData->keyArray[0], rightPageData->keyArray[rightOccupancy-1]);
                   parentPageData->pageNoArray[1] = Page::INVALID_NUMBER;
                   this->rootPageNum = parentPageData->pageNoArray[0];
+                  this->moveRootPin(parentPageId);
                 } else {
                   this->deleteEntryInNonLeaf<keyType, traits> (parentPage, parentPageOffset+1, parentOccupancy);
                 }
@@ -2238,6 +2912,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   traits::assign(leftPageData->keyArray[i],parentPageData->keyArray[j-1]);
                   leftPageData->pageNoArray[i] = parentPageData->pageNoArray[j-1];
                 }
+                leftPageData->slotUse = pLeftOccupancy + parentOccupancy - 2;
                 pathOfTraversal.pop_back();
                 if (!pathOfTraversal.empty()) {
                   PageId parentParentPageOffset = pathOfTraversal.back().first;
@@ -2271,6 +2946,7 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   traits::assign(parentPageData->keyArray[i],rightPageData->keyArray[j]);
                   parentPageData->pageNoArray[i] = rightPageData->pageNoArray[j];
                 }
+                parentPageData->slotUse = parentOccupancy + pRightOccupancy - 1;
                 pathOfTraversal.pop_back();
                 if (!pathOfTraversal.empty()) {
                   PageId parentParentPageOffset = pathOfTraversal.back().first;
@@ -2301,7 +2977,9 @@ const bool BTreeIndex::deleteKeyTemplate(const void* key) {
                   assert(0);
 #endif
                 }
+                const PageId oldRootPageNo = this->rootPageNum;
                 this->rootPageNum = parentPageId;
+                this->moveRootPin(oldRootPageNo);
                 if (leftOccupancy != -1) this->bufMgr->unPinPage(this->file, leftSibling, true);
                 if (rightOccupancy != -1) this->bufMgr->unPinPage(this->file, rightSibling, true);
                 this->bufMgr->unPinPage(this->file, parentPageId, true);
@@ -7,6 +7,8 @@
 
 #include <memory>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
@@ -36,19 +38,36 @@ BufMgr::BufMgr(std::uint32_t bufs)
   hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
 
   clockHand = bufs - 1;
+
+  for (int i = 0; i < PINCACHESLOTS; i++)
+  {
+  	pinCacheFile[i] = NULL;
+  	pinCachePageNo[i] = Page::INVALID_NUMBER;
+  	pinCacheFrame[i] = 0;
+  }
+  pinCacheHand = 0;
 }
 
 
 BufMgr::~BufMgr() {
   //Flush out all unwritten pages
-  for (std::uint32_t i = 0; i < numBufs; i++) 
+  //Batch the writebacks in ascending page order so the file sees one
+  //sequential sweep instead of writes scattered in frame order.
+  std::vector<std::pair<PageId, FrameId> > dirtyFrames;
+  for (std::uint32_t i = 0; i < numBufs; i++)
   {
   	BufDesc* tmpbuf = &bufDescTable[i];
   	if (tmpbuf->valid == true && tmpbuf->dirty == true)
 		{
-			tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[i]);
+			dirtyFrames.push_back(std::make_pair(tmpbuf->pageNo, i));
   	}
   }
+  std::sort(dirtyFrames.begin(), dirtyFrames.end());
+  for (std::size_t i = 0; i < dirtyFrames.size(); i++)
+  {
+  	BufDesc* tmpbuf = &bufDescTable[dirtyFrames[i].second];
+  	tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[dirtyFrames[i].second]);
+  }
 
   delete [] bufDescTable;
   delete [] bufPool;
@@ -83,6 +102,7 @@ void BufMgr::allocBuf(FrameId & frame)
         // hasn't been referenced and is not pinned, use it
         // remove previous entry from hash table
         hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
+        pinCacheRemove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
         found = true;
         break;
       }
@@ -124,6 +144,14 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
   std::cout << "readPage called on page " << pageNo << "\n";
   #endif
   FrameId frameNo = 0;
+  // fast path: the page was pinned recently, skip the hash table
+  if (pinCacheLookup(file, pageNo, frameNo))
+  {
+    bufDescTable[frameNo].refbit = true;
+    bufDescTable[frameNo].pinCnt++;
+    page = &bufPool[frameNo];
+    return;
+  }
 	try
 	{
   	hashTable->lookup(file, pageNo, frameNo);
@@ -150,15 +178,20 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
     // insert in the hash table
     hashTable->insert(file, pageNo, frameNo);
   }
+  pinCacheInsert(file, pageNo, frameNo);
 }
 
 
 void BufMgr::unPinPage(File* file, const PageId pageNo, 
 			     const bool dirty) 
 {
-  // lookup in hashtable
+  // lookup in the fast-path cache first, then the hashtable
   FrameId frameNo = 0;
-  hashTable->lookup(file, pageNo, frameNo);
+  if (!pinCacheLookup(file, pageNo, frameNo))
+  {
+    hashTable->lookup(file, pageNo, frameNo);
+    pinCacheInsert(file, pageNo, frameNo);
+  }
 
   if (dirty == true) bufDescTable[frameNo].dirty = dirty;
 
@@ -175,6 +208,10 @@ void BufMgr::unPinPage(File* file, const PageId pageNo,
 
 void BufMgr::flushFile(const File* file) 
 {
+  // First pass validates and collects the dirty frames; the writebacks are
+  // then issued in ascending page order so the file sees one sequential
+  // sweep instead of writes scattered in frame order.
+  std::vector<std::pair<PageId, FrameId> > dirtyFrames;
   for (std::uint32_t i = 0; i < numBufs; i++)
 	{
   	BufDesc* tmpbuf = &(bufDescTable[i]);
@@ -185,16 +222,31 @@ void BufMgr::flushFile(const File* file)
 
 	    if (tmpbuf->dirty == true)
 			{
-				//if ((status = tmpbuf->file->writePage(tmpbuf->pageNo, &(bufPool[i]))) != OK)
-				tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[i]);
-				tmpbuf->dirty = false;
+				dirtyFrames.push_back(std::make_pair(tmpbuf->pageNo, i));
     	}
+  	}
+		else if (tmpbuf->valid == false && tmpbuf->file == file)
+  		throw BadBufferException(tmpbuf->frameNo, tmpbuf->dirty, tmpbuf->valid, tmpbuf->refbit);
+  }
+
+  std::sort(dirtyFrames.begin(), dirtyFrames.end());
+  for (std::size_t i = 0; i < dirtyFrames.size(); i++)
+	{
+  	BufDesc* tmpbuf = &(bufDescTable[dirtyFrames[i].second]);
+		//if ((status = tmpbuf->file->writePage(tmpbuf->pageNo, &(bufPool[i]))) != OK)
+		tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[dirtyFrames[i].second]);
+		tmpbuf->dirty = false;
+  }
 
+  for (std::uint32_t i = 0; i < numBufs; i++)
+	{
+  	BufDesc* tmpbuf = &(bufDescTable[i]);
+  	if(tmpbuf->valid == true && tmpbuf->file == file)
+		{
     	hashTable->remove(file,tmpbuf->pageNo);
+    	pinCacheRemove(file, tmpbuf->pageNo);
     	tmpbuf->Clear();
   	}
-		else if (tmpbuf->valid == false && tmpbuf->file == file)
-  		throw BadBufferException(tmpbuf->frameNo, tmpbuf->dirty, tmpbuf->valid, tmpbuf->refbit);
   }
 }
 
@@ -209,8 +261,9 @@ void BufMgr::disposePage(File* file, const PageId pageNo)
 	bufDescTable[frameNo].Clear();
 
 	hashTable->remove(file, pageNo);
+	pinCacheRemove(file, pageNo);
 
-  // deallocate it in the file	
+  // deallocate it in the file
   file->deletePage(pageNo);
 }
 
@@ -232,9 +285,10 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
 
   // insert in the hash table
   hashTable->insert(file, pageNo, frameNo);
+  pinCacheInsert(file, pageNo, frameNo);
 }
 
-void BufMgr::printSelf(void) 
+void BufMgr::printSelf(void)
 {
   BufDesc* tmpbuf;
 	int validFrames = 0;
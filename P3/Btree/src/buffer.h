@@ -182,12 +182,77 @@ class BufMgr
   BufDesc *bufDescTable;
 
 	/**
-   * Maintains Buffer pool usage statistics 
+   * Maintains Buffer pool usage statistics
 	 */
   BufStats bufStats;
 
 	/**
-	 * Allocate a free frame.  
+   * Number of slots in the recently-pinned fast-path cache
+	 */
+  static const int PINCACHESLOTS = 8;
+
+	/**
+   * Small cache of the most recently pinned (file, page) to frame mappings.
+   * Scanned linearly before the hash table on readPage/unPinPage; a scan
+   * re-pinning its current leaf hits here without touching the hash table.
+	 */
+  File* pinCacheFile[PINCACHESLOTS];
+  PageId pinCachePageNo[PINCACHESLOTS];
+  FrameId pinCacheFrame[PINCACHESLOTS];
+
+	/**
+   * Next fast-path cache slot to be replaced, advanced round-robin
+	 */
+  int pinCacheHand;
+
+	/**
+	 * Look up a (file, page) mapping in the fast-path cache.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number
+	 * @param frameNo	Frame reference, frame ID of the cached mapping returned via this variable
+	 * @return True if the mapping was cached
+	 */
+  bool pinCacheLookup(File* file, const PageId pageNo, FrameId& frameNo)
+  {
+		for (int i = 0; i < PINCACHESLOTS; i++)
+		{
+			if (pinCacheFile[i] == file && pinCachePageNo[i] == pageNo)
+			{
+				frameNo = pinCacheFrame[i];
+				return true;
+			}
+		}
+		return false;
+  }
+
+	/**
+	 * Remember a (file, page) to frame mapping in the fast-path cache,
+	 * replacing the oldest entry.
+	 */
+  void pinCacheInsert(File* file, const PageId pageNo, const FrameId frameNo)
+  {
+		pinCacheFile[pinCacheHand] = file;
+		pinCachePageNo[pinCacheHand] = pageNo;
+		pinCacheFrame[pinCacheHand] = frameNo;
+		pinCacheHand = (pinCacheHand + 1) % PINCACHESLOTS;
+  }
+
+	/**
+	 * Drop a (file, page) mapping from the fast-path cache. Must be called
+	 * wherever the hash table mapping for the page is removed.
+	 */
+  void pinCacheRemove(const File* file, const PageId pageNo)
+  {
+		for (int i = 0; i < PINCACHESLOTS; i++)
+		{
+			if (pinCacheFile[i] == file && pinCachePageNo[i] == pageNo)
+				pinCacheFile[i] = NULL;
+		}
+  }
+
+	/**
+	 * Allocate a free frame.
 	 *
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
 	 * @throws BufferExceededException If no such buffer is found which can be allocated
@@ -62,6 +62,7 @@ void createRelationRandom();
 void intTests();
 void intDeleteTests();
 int intScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int intBatchScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
 void indexTests();
 void indexDeleteTests();
 void doubleTests();
@@ -473,6 +474,9 @@ void intTests()
 	checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
 	checkPassFail(intScan(&index,0,GTE,5005,LT), 5000)
 	checkPassFail(intScan(&index,5000,GTE,5005,LT), 0)
+	checkPassFail(intBatchScan(&index,300,GT,400,LT), 99)
+	checkPassFail(intBatchScan(&index,0,GTE,5000,LT), 5000)
+	checkPassFail(intBatchScan(&index,5000,GTE,5005,LT), 0)
 }
 
 
@@ -589,6 +593,83 @@ int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operato
 	return numResults;
 }
 
+int intBatchScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  RecordId scanRid;
+
+  std::cout << "Batch scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+	// Collect the reference answer one record at a time through scanNext.
+  std::vector<RecordId> expected;
+	try
+	{
+  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+	while(1)
+	{
+		try
+		{
+			index->scanNext(scanRid);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		expected.push_back(scanRid);
+	}
+  index->endScan();
+
+	// Re-run the same scan through scanNextBatch and check it hands out
+	// exactly the same records in the same order.
+  std::vector<RecordId> batched;
+  RecordId batchBuf[100];
+  index->startScan(&lowVal, lowOp, &highVal, highOp);
+	while(1)
+	{
+		int n;
+		try
+		{
+			n = index->scanNextBatch(batchBuf, 100);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		for(int i = 0; i < n; i++)
+		{
+			batched.push_back(batchBuf[i]);
+		}
+	}
+  index->endScan();
+
+  if( batched.size() != expected.size() )
+  {
+    std::cout << "Batch scan returned " << batched.size() << " records, scanNext returned " << expected.size() << std::endl;
+    return -1;
+  }
+  for( size_t i = 0; i < expected.size(); i++ )
+  {
+    if( batched[i].page_number != expected[i].page_number || batched[i].slot_number != expected[i].slot_number )
+    {
+      std::cout << "Batch scan record " << i << " does not match scanNext" << std::endl;
+      return -1;
+    }
+  }
+  std::cout << "Number of results: " << batched.size() << std::endl;
+  std::cout << std::endl;
+
+	return (int)batched.size();
+}
+
 // -----------------------------------------------------------------------------
 // doubleTests
 // -----------------------------------------------------------------------------